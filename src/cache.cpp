@@ -0,0 +1,178 @@
+#include "cache.hpp"
+
+#include <cctype>
+#include <cstring>
+#include <sstream>
+
+namespace {
+
+// Stored in ShardedLRUCache<Newick2VResult>: keep the two Newick -> vector conversions apart
+const char FROM_NEWICK_PREFIX = 'f';
+const char NEWICK2V_PREFIX = 'n';
+
+std::string vectorKey(const std::vector<int> &v) {
+    std::string key(v.size() * sizeof(int), '\0');
+    if (!v.empty()) {
+        std::memcpy(&key[0], v.data(), key.size());
+    }
+    return key;
+}
+
+/**
+ * Key of a Newick -> vector conversion. The other parameters change the result (e.g., newick2v
+ * throws if num_leaves does not match the tree), so they are part of it. The outgroup is only
+ * used by RerootMethod::LEAF, and is length-prefixed to keep keys unambiguous.
+ */
+std::string conversionKey(char prefix, int num_leaves, RerootMethod reroot_method,
+                          const std::string &outgroup, const std::string &newick) {
+    const std::string used_outgroup = reroot_method == RerootMethod::LEAF ? outgroup : "";
+
+    std::ostringstream oss;
+    oss << prefix << num_leaves << ',' << static_cast<int>(reroot_method) << ','
+        << used_outgroup.size() << ',' << used_outgroup << ';' << newick;
+    return oss.str();
+}
+
+/**
+ * Newick string to key and convert: midpoint rooting depends on branch lengths, so only the
+ * other methods share entries per topology
+ */
+std::string keyNewick(const std::string &newick, RerootMethod reroot_method) {
+    return reroot_method == RerootMethod::MIDPOINT ? newick : normalizeNewick(newick);
+}
+
+std::size_t resultBytes(const Newick2VResult &result) {
+    std::size_t bytes = sizeof(Newick2VResult) + result.v.size() * sizeof(int);
+    for (const auto &pair : result.mapping) {
+        bytes += pair.first.size() + pair.second.size();
+    }
+    return bytes;
+}
+
+bool isDelimiter(char c) { return c == ',' || c == '(' || c == ')' || c == ';'; }
+
+}  // namespace
+
+std::uint64_t hashBytes(const std::string &bytes) {
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : bytes) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+std::string normalizeNewick(const std::string &newick) {
+    std::string normalized;
+    normalized.reserve(newick.size());
+
+    // Between a closing parenthesis and the next delimiter: parent label or branch length
+    bool after_parent = false;
+    std::size_t i = 0;
+    while (i < newick.size()) {
+        const char c = newick[i];
+        if (c == '[') {
+            const std::size_t end = newick.find(']', i);
+            i = end == std::string::npos ? newick.size() : end + 1;
+        } else if (c == ':') {
+            // Branch length
+            while (i < newick.size() && !isDelimiter(newick[i]) && newick[i] != '[') {
+                ++i;
+            }
+        } else if (isDelimiter(c)) {
+            normalized.push_back(c);
+            after_parent = c == ')';
+            ++i;
+        } else {
+            if (!after_parent && !std::isspace(static_cast<unsigned char>(c))) {
+                normalized.push_back(c);
+            }
+            ++i;
+        }
+    }
+
+    return normalized;
+}
+
+ConversionCache::ConversionCache(std::size_t max_bytes, int num_shards)
+    : bypass_(false), newicks_(max_bytes / 2, num_shards), vectors_(max_bytes / 2, num_shards) {}
+
+std::string ConversionCache::toNewick(const std::vector<int> &v) {
+    if (bypass_) {
+        return ::toNewick(v);
+    }
+
+    const std::string key = vectorKey(v);
+    const std::uint64_t hash = hashBytes(key);
+
+    std::string newick;
+    if (newicks_.get(key, hash, newick)) {
+        return newick;
+    }
+
+    // Convert outside of the shard lock
+    newick = ::toNewick(v);
+    newicks_.put(key, hash, newick, newick.size());
+    return newick;
+}
+
+std::vector<int> ConversionCache::fromNewick(const std::string &newick,
+                                             RerootMethod reroot_method, int outgroup) {
+    if (bypass_) {
+        return ::fromNewick(newick, reroot_method, outgroup);
+    }
+
+    const std::string normalized = keyNewick(newick, reroot_method);
+    const std::string key = conversionKey(FROM_NEWICK_PREFIX, -1, reroot_method,
+                                          std::to_string(outgroup), normalized);
+    const std::uint64_t hash = hashBytes(key);
+
+    Newick2VResult result;
+    if (vectors_.get(key, hash, result)) {
+        return result.v;
+    }
+
+    result.v = ::fromNewick(normalized, reroot_method, outgroup);
+    result.num_leaves = result.v.size() + 1;
+    vectors_.put(key, hash, result, resultBytes(result));
+    return result.v;
+}
+
+Newick2VResult ConversionCache::newick2v(const std::string &newick, int num_leaves,
+                                         RerootMethod reroot_method,
+                                         const std::string &outgroup) {
+    if (bypass_) {
+        std::string copy = newick;
+        return ::newick2v(copy, num_leaves, reroot_method, outgroup);
+    }
+
+    std::string normalized = keyNewick(newick, reroot_method);
+    const std::string key =
+        conversionKey(NEWICK2V_PREFIX, num_leaves, reroot_method, outgroup, normalized);
+    const std::uint64_t hash = hashBytes(key);
+
+    Newick2VResult result;
+    if (vectors_.get(key, hash, result)) {
+        return result;
+    }
+
+    result = ::newick2v(normalized, num_leaves, reroot_method, outgroup);
+    vectors_.put(key, hash, result, resultBytes(result));
+    return result;
+}
+
+CacheStats ConversionCache::stats() const {
+    CacheStats total = newicks_.stats();
+    const CacheStats other = vectors_.stats();
+    total.hits += other.hits;
+    total.misses += other.misses;
+    total.evictions += other.evictions;
+    total.entries += other.entries;
+    total.bytes += other.bytes;
+    return total;
+}
+
+void ConversionCache::clear() {
+    newicks_.clear();
+    vectors_.clear();
+}
@@ -0,0 +1,272 @@
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "phylo2vec.hpp"
+
+/**
+ * Thread-safe LRU caches in front of the conversion functions
+ *
+ * Entries are spread over independent shards (each with its own lock and LRU list) according to
+ * a 64-bit hash of their key, so that concurrent lookups rarely contend. Keys are compared in
+ * full on lookup: a hash collision can never return the wrong tree.
+ */
+
+/**
+ * @brief Counters of a cache (summed over all shards)
+ * bytes: estimated memory used by the entries (keys, values and bookkeeping)
+ */
+struct CacheStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+    std::size_t entries = 0;
+    std::size_t bytes = 0;
+};
+
+/**
+ * @brief 64-bit FNV-1a hash of a byte string
+ */
+std::uint64_t hashBytes(const std::string &bytes);
+
+/**
+ * @brief Cache key of a Newick string: whitespace, comments ([...]), branch lengths and parent
+ * labels are removed, so that all the annotated versions of a topology share the same entry.
+ * The result is a valid input for toVector.
+ */
+std::string normalizeNewick(const std::string &newick);
+
+/**
+ * @brief Sharded LRU cache with a byte budget
+ *
+ * @tparam Value type of the cached values
+ */
+template <typename Value>
+class ShardedLRUCache {
+   public:
+    /**
+     * @param max_bytes memory budget, split evenly between the shards
+     * @param num_shards number of shards
+     */
+    ShardedLRUCache(std::size_t max_bytes, int num_shards) : shard_budget_(0) {
+        if (num_shards <= 0) {
+            num_shards = 1;
+        }
+        shard_budget_ = max_bytes / num_shards;
+        for (int i = 0; i < num_shards; ++i) {
+            shards_.emplace_back(new Shard());
+        }
+    }
+
+    /**
+     * @brief Look up a key. On a hit, the entry becomes the most recently used of its shard.
+     *
+     * @param key full key
+     * @param hash hashBytes(key)
+     * @param value output value (unchanged on a miss)
+     * @return true on a hit
+     */
+    bool get(const std::string &key, std::uint64_t hash, Value &value) {
+        Shard &shard = getShard(hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto it = find(shard, key, hash);
+        if (it == shard.entries.end()) {
+            ++shard.misses;
+            return false;
+        }
+
+        shard.entries.splice(shard.entries.begin(), shard.entries, it);
+        value = it->value;
+        ++shard.hits;
+        return true;
+    }
+
+    /**
+     * @brief Insert (or refresh) an entry, evicting the least recently used entries of its shard
+     * if needed. Entries larger than the budget of a shard are not cached.
+     *
+     * @param key full key
+     * @param hash hashBytes(key)
+     * @param value value to cache
+     * @param value_bytes estimated size of value
+     */
+    void put(const std::string &key, std::uint64_t hash, Value value, std::size_t value_bytes) {
+        const std::size_t bytes = key.size() + value_bytes + ENTRY_OVERHEAD;
+        if (bytes > shard_budget_) {
+            return;
+        }
+
+        Shard &shard = getShard(hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        // Another thread may have inserted the same key since our lookup
+        auto it = find(shard, key, hash);
+        if (it != shard.entries.end()) {
+            shard.entries.splice(shard.entries.begin(), shard.entries, it);
+            return;
+        }
+
+        while (!shard.entries.empty() && shard.bytes + bytes > shard_budget_) {
+            evictLast(shard);
+        }
+
+        shard.entries.push_front(Entry{key, hash, std::move(value), bytes});
+        shard.index.emplace(hash, shard.entries.begin());
+        shard.bytes += bytes;
+    }
+
+    CacheStats stats() const {
+        CacheStats total;
+        for (const auto &shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            total.hits += shard->hits;
+            total.misses += shard->misses;
+            total.evictions += shard->evictions;
+            total.entries += shard->entries.size();
+            total.bytes += shard->bytes;
+        }
+        return total;
+    }
+
+    /**
+     * @brief Remove all entries (counters are kept)
+     */
+    void clear() {
+        for (auto &shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            shard->entries.clear();
+            shard->index.clear();
+            shard->bytes = 0;
+        }
+    }
+
+   private:
+    // Approximate bookkeeping cost of an entry: list node, index node, key/value headers
+    static const std::size_t ENTRY_OVERHEAD = 128;
+
+    struct Entry {
+        std::string key;
+        std::uint64_t hash;
+        Value value;
+        std::size_t bytes;
+    };
+    typedef typename std::list<Entry>::iterator EntryIterator;
+
+    struct Shard {
+        std::mutex mutex;
+        // Most recently used first
+        std::list<Entry> entries;
+        std::unordered_multimap<std::uint64_t, EntryIterator> index;
+        std::size_t bytes = 0;
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t evictions = 0;
+    };
+
+    Shard &getShard(std::uint64_t hash) { return *shards_[hash % shards_.size()]; }
+
+    static EntryIterator find(Shard &shard, const std::string &key, std::uint64_t hash) {
+        auto range = shard.index.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second->key == key) {
+                return it->second;
+            }
+        }
+        return shard.entries.end();
+    }
+
+    static void evictLast(Shard &shard) {
+        EntryIterator last = std::prev(shard.entries.end());
+        auto range = shard.index.equal_range(last->hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == last) {
+                shard.index.erase(it);
+                break;
+            }
+        }
+        shard.bytes -= last->bytes;
+        shard.entries.erase(last);
+        ++shard.evictions;
+    }
+
+    std::size_t shard_budget_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+/**
+ * @brief Memoized toNewick/fromNewick/newick2v for workloads that convert the same topologies
+ * over and over (e.g., the current best trees of a search, MCMC samples).
+ *
+ * Vectors are keyed by their content, Newick strings by normalizeNewick (except for midpoint
+ * rooting, which depends on branch lengths). Half of the byte budget goes to the
+ * vector -> Newick direction, the other half to Newick -> vector.
+ * All methods can be called concurrently.
+ *
+ * Usage:
+ *     ConversionCache cache(256 << 20);
+ *     std::string newick = cache.toNewick(v);
+ */
+class ConversionCache {
+   public:
+    /**
+     * @param max_bytes memory budget of the cache
+     * @param num_shards number of independently locked shards
+     */
+    explicit ConversionCache(std::size_t max_bytes = 64 << 20, int num_shards = 16);
+
+    /**
+     * @brief Cached toNewick
+     */
+    std::string toNewick(const std::vector<int> &v);
+
+    /**
+     * @brief Cached fromNewick (optionally rerooted, cf. RerootMethod)
+     */
+    std::vector<int> fromNewick(const std::string &newick,
+                                RerootMethod reroot_method = RerootMethod::NONE,
+                                int outgroup = -1);
+
+    /**
+     * @brief Cached newick2v (the input Newick is not modified)
+     * Entries are keyed by all parameters, so a num_leaves mismatch throws as with newick2v.
+     */
+    Newick2VResult newick2v(const std::string &newick, int num_leaves = -1,
+                            RerootMethod reroot_method = RerootMethod::NONE,
+                            const std::string &outgroup = "");
+
+    /**
+     * @brief Skip the cache entirely (no lookups, insertions or counter updates), e.g. for
+     * one-off batch jobs that would only pollute it.
+     */
+    void setBypass(bool bypass) { bypass_ = bypass; }
+    bool bypass() const { return bypass_; }
+
+    /**
+     * @brief Counters summed over both directions
+     */
+    CacheStats stats() const;
+
+    /**
+     * @brief Remove all entries
+     */
+    void clear();
+
+   private:
+    std::atomic<bool> bypass_;
+    ShardedLRUCache<std::string> newicks_;
+    ShardedLRUCache<Newick2VResult> vectors_;
+};
+
+#endif  // CACHE_HPP
@@ -0,0 +1,323 @@
+#include "chain.hpp"
+
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#include "phylo2vec.hpp"
+
+namespace {
+
+/**
+ * @brief Check a decoded v[i] (0 <= v[i] <= 2i, cf. check_v)
+ */
+int checkValue(std::uint64_t value, std::uint64_t i) {
+    if (value > 2 * i) {
+        std::ostringstream oss;
+        oss << "Invalid chain: value " << value << " out of range at index " << i << ".";
+        throw std::runtime_error(oss.str());
+    }
+    return static_cast<int>(value);
+}
+
+}  // namespace
+
+ChainWriter::ChainWriter(std::ostream &out, int k, int keyframe_interval)
+    : out_(out),
+      k_(k),
+      keyframe_interval_(keyframe_interval),
+      num_bytes_(0),
+      num_samples_(0),
+      closed_(false) {
+    if (k < 0 || k > CHAIN_MAX_K || keyframe_interval < 1) {
+        std::ostringstream oss;
+        oss << "k should be in [0, " << CHAIN_MAX_K
+            << "] and keyframe_interval >= 1, found k = " << k
+            << " and keyframe_interval = " << keyframe_interval << ".";
+        throw std::invalid_argument(oss.str());
+    }
+    // Sized once k is known to be valid
+    prev_.assign(k, 0);
+
+    for (int i = 0; i < 4; ++i) {
+        putByte(CHAIN_MAGIC[i]);
+    }
+    putVarint(CHAIN_VERSION);
+    putVarint(k);
+    putVarint(keyframe_interval);
+}
+
+ChainWriter::~ChainWriter() {
+    if (!closed_) {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+}
+
+void ChainWriter::putByte(std::uint8_t byte) {
+    out_.put(static_cast<char>(byte));
+    ++num_bytes_;
+}
+
+void ChainWriter::putVarint(std::uint64_t value) {
+    while (value >= 0x80) {
+        putByte(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    putByte(static_cast<std::uint8_t>(value));
+}
+
+void ChainWriter::write(const std::vector<int> &v) {
+    if (closed_) {
+        throw std::logic_error("Cannot write to a closed chain.");
+    }
+
+    if (v.size() != static_cast<std::size_t>(k_)) {
+        std::ostringstream oss;
+        oss << "All vectors of a chain should have " << k_ << " entries, found " << v.size()
+            << ".";
+        throw std::invalid_argument(oss.str());
+    }
+
+    check_v(v);
+
+    if (num_samples_ % keyframe_interval_ == 0) {
+        keyframe_offsets_.push_back(num_bytes_);
+
+        putByte(KEYFRAME_TAG);
+        for (int val : v) {
+            putVarint(val);
+        }
+    } else {
+        std::vector<int> changes;
+        for (int i = 0; i < k_; ++i) {
+            if (v[i] != prev_[i]) {
+                changes.push_back(i);
+            }
+        }
+
+        putByte(DELTA_TAG);
+        putVarint(changes.size());
+
+        int prev_idx = -1;
+        for (int idx : changes) {
+            putVarint(idx - prev_idx - 1);
+            putVarint(v[idx]);
+            prev_idx = idx;
+        }
+    }
+
+    prev_ = v;
+    ++num_samples_;
+}
+
+void ChainWriter::close() {
+    if (closed_) {
+        return;
+    }
+
+    const std::uint64_t footer_offset = num_bytes_;
+
+    putByte(END_TAG);
+    putVarint(num_samples_);
+    putVarint(keyframe_offsets_.size());
+    for (std::uint64_t offset : keyframe_offsets_) {
+        putVarint(offset);
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        putByte(static_cast<std::uint8_t>(footer_offset >> (8 * i)));
+    }
+
+    out_.flush();
+    closed_ = true;
+}
+
+ChainReader::ChainReader(std::istream &in)
+    : in_(in),
+      start_(in.tellg()),
+      at_end_(false),
+      has_footer_(false),
+      num_samples_(0) {
+    for (int i = 0; i < 4; ++i) {
+        if (getByte() != static_cast<std::uint8_t>(CHAIN_MAGIC[i])) {
+            throw std::runtime_error("Invalid chain: wrong magic bytes.");
+        }
+    }
+
+    std::uint64_t version = getVarint();
+    if (version != CHAIN_VERSION) {
+        std::ostringstream oss;
+        oss << "Unsupported chain version: " << version << ".";
+        throw std::runtime_error(oss.str());
+    }
+
+    const std::uint64_t k = getVarint();
+    if (k > static_cast<std::uint64_t>(CHAIN_MAX_K)) {
+        std::ostringstream oss;
+        oss << "Invalid chain: vector size " << k << " exceeds " << CHAIN_MAX_K << ".";
+        throw std::runtime_error(oss.str());
+    }
+
+    const std::uint64_t keyframe_interval = getVarint();
+    if (keyframe_interval < 1 ||
+        keyframe_interval > static_cast<std::uint64_t>(std::numeric_limits<int>::max())) {
+        throw std::runtime_error("Invalid chain: keyframe interval should be >= 1.");
+    }
+
+    k_ = static_cast<int>(k);
+    keyframe_interval_ = static_cast<int>(keyframe_interval);
+    curr_.assign(k_, 0);
+}
+
+std::uint8_t ChainReader::getByte() {
+    int byte = in_.get();
+    if (byte == std::istream::traits_type::eof()) {
+        throw std::runtime_error("Invalid chain: unexpected end of stream.");
+    }
+    return static_cast<std::uint8_t>(byte);
+}
+
+std::uint64_t ChainReader::getVarint() {
+    std::uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        std::uint8_t byte = getByte();
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    throw std::runtime_error("Invalid chain: varint too long.");
+}
+
+bool ChainReader::next(std::vector<int> &v) {
+    if (at_end_) {
+        return false;
+    }
+
+    std::uint8_t tag = getByte();
+
+    if (tag == KEYFRAME_TAG) {
+        for (int i = 0; i < k_; ++i) {
+            curr_[i] = checkValue(getVarint(), i);
+        }
+    } else if (tag == DELTA_TAG) {
+        std::uint64_t num_changes = getVarint();
+
+        std::uint64_t idx = 0;
+        for (std::uint64_t i = 0; i < num_changes; ++i) {
+            // Indices are strictly increasing (idx < k_). Compared before adding, so that a huge
+            // gap cannot wrap around.
+            const std::uint64_t step = i > 0 ? 1 : 0;
+            const std::uint64_t gap = getVarint();
+            if (gap >= static_cast<std::uint64_t>(k_) - idx - step) {
+                throw std::runtime_error("Invalid chain: delta index out of range.");
+            }
+            idx += gap + step;
+            curr_[idx] = checkValue(getVarint(), idx);
+        }
+    } else if (tag == END_TAG) {
+        at_end_ = true;
+        return false;
+    } else {
+        throw std::runtime_error("Invalid chain: unknown record tag.");
+    }
+
+    v = curr_;
+    return true;
+}
+
+void ChainReader::readFooter() {
+    const std::streampos pos = in_.tellg();
+
+    in_.clear();
+    in_.seekg(-8, std::ios::end);
+
+    std::uint64_t footer_offset = 0;
+    for (int i = 0; i < 8; ++i) {
+        footer_offset |= static_cast<std::uint64_t>(getByte()) << (8 * i);
+    }
+
+    in_.seekg(start_ + static_cast<std::streamoff>(footer_offset));
+    if (!in_ || getByte() != END_TAG) {
+        throw std::runtime_error("Invalid chain: footer not found (is the stream seekable?).");
+    }
+
+    num_samples_ = getVarint();
+    const std::uint64_t num_keyframes = getVarint();
+    // One keyframe every keyframe_interval samples, starting with the first one
+    if (num_keyframes != num_samples_ / keyframe_interval_ +
+                             (num_samples_ % keyframe_interval_ != 0 ? 1 : 0)) {
+        throw std::runtime_error("Invalid chain: wrong number of keyframes in the footer.");
+    }
+
+    // Read offsets one at a time: a corrupt count ends the stream instead of a huge allocation
+    keyframe_offsets_.clear();
+    for (std::uint64_t i = 0; i < num_keyframes; ++i) {
+        const std::uint64_t offset = getVarint();
+        if (offset >= footer_offset) {
+            throw std::runtime_error("Invalid chain: keyframe offset past the footer.");
+        }
+        keyframe_offsets_.push_back(offset);
+    }
+
+    has_footer_ = true;
+
+    in_.clear();
+    in_.seekg(pos);
+}
+
+std::size_t ChainReader::size() {
+    if (!has_footer_) {
+        readFooter();
+    }
+    return num_samples_;
+}
+
+std::vector<int> ChainReader::get(std::size_t i) {
+    if (i >= size()) {
+        std::ostringstream oss;
+        oss << "Sample " << i << " out of range for a chain of " << num_samples_ << " samples.";
+        throw std::out_of_range(oss.str());
+    }
+
+    const std::size_t keyframe = i / keyframe_interval_;
+
+    in_.clear();
+    in_.seekg(start_ + static_cast<std::streamoff>(keyframe_offsets_[keyframe]));
+    at_end_ = false;
+
+    std::vector<int> v;
+    for (std::size_t j = keyframe * keyframe_interval_; j <= i; ++j) {
+        next(v);
+    }
+
+    return v;
+}
+
+std::string encodeChain(const std::vector<std::vector<int>> &vs, int keyframe_interval) {
+    std::ostringstream oss(std::ios::binary);
+    {
+        ChainWriter writer(oss, vs.empty() ? 0 : vs[0].size(), keyframe_interval);
+        for (const auto &v : vs) {
+            writer.write(v);
+        }
+        writer.close();
+    }
+    return oss.str();
+}
+
+std::vector<std::vector<int>> decodeChain(const std::string &data) {
+    std::istringstream iss(data, std::ios::binary);
+    ChainReader reader(iss);
+
+    std::vector<std::vector<int>> vs;
+    std::vector<int> v;
+    while (reader.next(v)) {
+        vs.push_back(v);
+    }
+
+    return vs;
+}
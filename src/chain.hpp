@@ -0,0 +1,137 @@
+#ifndef CHAIN_HPP
+#define CHAIN_HPP
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Delta-compressed storage for chains of Phylo2Vec vectors (e.g., MCMC samples)
+ *
+ * Layout (all integers are LEB128 varints unless stated otherwise):
+ * header: "P2VC", version, k, keyframe interval
+ * records: KEYFRAME_TAG + v[0..k-1]
+ *          DELTA_TAG + number of changes + (index gap, value) for each change
+ * footer: END_TAG + number of samples + number of keyframes + offset of each keyframe
+ *         + offset of the footer (8 bytes, little-endian)
+ *
+ * Every keyframe_interval-th sample is stored as a keyframe, so that sample i can be decoded
+ * from the keyframe i / keyframe_interval and at most keyframe_interval - 1 deltas.
+ */
+
+const char CHAIN_MAGIC[] = "P2VC";
+const int CHAIN_VERSION = 1;
+const std::uint8_t KEYFRAME_TAG = 0;
+const std::uint8_t DELTA_TAG = 1;
+const std::uint8_t END_TAG = 2;
+// Largest vector size accepted in a chain header (bounds the memory allocated when reading)
+const int CHAIN_MAX_K = 1 << 26;
+
+/**
+ * @brief Streaming encoder of a chain of vectors
+ * Output streams do not need to be seekable.
+ */
+class ChainWriter {
+   public:
+    /**
+     * @param out output stream (binary)
+     * @param k size of the vectors (number of leaves - 1)
+     * @param keyframe_interval distance between two keyframes
+     */
+    ChainWriter(std::ostream &out, int k, int keyframe_interval = 64);
+    ~ChainWriter();
+
+    /**
+     * @brief Append a vector to the chain
+     *
+     * @param v Phylo2Vec vector of size k
+     */
+    void write(const std::vector<int> &v);
+
+    /**
+     * @brief Write the footer. No vector can be written afterwards.
+     */
+    void close();
+
+   private:
+    void putByte(std::uint8_t byte);
+    void putVarint(std::uint64_t value);
+
+    std::ostream &out_;
+    int k_;
+    int keyframe_interval_;
+    std::uint64_t num_bytes_;
+    std::uint64_t num_samples_;
+    std::vector<std::uint64_t> keyframe_offsets_;
+    std::vector<int> prev_;
+    bool closed_;
+};
+
+/**
+ * @brief Decoder of a chain of vectors
+ * next() decodes samples sequentially; get() requires a seekable input stream.
+ */
+class ChainReader {
+   public:
+    /**
+     * @param in input stream (binary), positioned at the start of the header
+     */
+    explicit ChainReader(std::istream &in);
+
+    /**
+     * @brief Decode the next sample
+     *
+     * @param v output vector
+     * @return false if the end of the chain was reached
+     */
+    bool next(std::vector<int> &v);
+
+    /**
+     * @brief Random access to sample i (sequential decoding then resumes from sample i + 1)
+     *
+     * @param i index of the sample
+     */
+    std::vector<int> get(std::size_t i);
+
+    /**
+     * @brief Number of samples in the chain (reads the footer)
+     */
+    std::size_t size();
+
+    int k() const { return k_; }
+
+   private:
+    std::uint8_t getByte();
+    std::uint64_t getVarint();
+    void readFooter();
+
+    std::istream &in_;
+    std::streampos start_;
+    int k_;
+    int keyframe_interval_;
+    std::vector<int> curr_;
+    bool at_end_;
+    bool has_footer_;
+    std::uint64_t num_samples_;
+    std::vector<std::uint64_t> keyframe_offsets_;
+};
+
+/**
+ * @brief Encode a whole chain of vectors in memory
+ *
+ * @param vs Phylo2Vec vectors, all of the same size
+ * @param keyframe_interval distance between two keyframes
+ * @return std::string encoded chain
+ */
+std::string encodeChain(const std::vector<std::vector<int>> &vs, int keyframe_interval = 64);
+
+/**
+ * @brief Decode a whole chain of vectors from memory
+ *
+ * @param data encoded chain (cf. encodeChain)
+ */
+std::vector<std::vector<int>> decodeChain(const std::string &data);
+
+#endif  // CHAIN_HPP
@@ -0,0 +1,517 @@
+#include "compression.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+#ifdef PHYLO2VEC_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef PHYLO2VEC_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+const unsigned char GZIP_MAGIC[] = {0x1f, 0x8b};
+const unsigned char ZSTD_MAGIC[] = {0x28, 0xb5, 0x2f, 0xfd};
+// Compressed data is read from (or written to) disk in blocks of this number of bytes
+const std::size_t COMPRESSED_BLOCK_SIZE = 1 << 18;
+
+Compression detectCompression(const unsigned char *bytes, std::size_t size) {
+    if (size >= sizeof(GZIP_MAGIC) && std::memcmp(bytes, GZIP_MAGIC, sizeof(GZIP_MAGIC)) == 0) {
+        return Compression::GZIP;
+    }
+    if (size >= sizeof(ZSTD_MAGIC) && std::memcmp(bytes, ZSTD_MAGIC, sizeof(ZSTD_MAGIC)) == 0) {
+        return Compression::ZSTD;
+    }
+    return Compression::NONE;
+}
+
+Compression compressionFromPath(const std::string &path) {
+    auto endsWith = [&](const std::string &suffix) {
+        return path.size() >= suffix.size() &&
+               path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+
+    if (endsWith(".gz")) {
+        return Compression::GZIP;
+    }
+    if (endsWith(".zst")) {
+        return Compression::ZSTD;
+    }
+    return Compression::NONE;
+}
+
+/**
+ * @brief Input file whose first bytes (read to detect the compression) are replayed
+ */
+struct FileSource {
+    std::FILE *file;
+    std::string prefix;
+    std::size_t prefix_pos;
+
+    std::size_t read(char *out, std::size_t size) {
+        std::size_t n = std::min(size, prefix.size() - prefix_pos);
+        std::memcpy(out, prefix.data() + prefix_pos, n);
+        prefix_pos += n;
+
+        if (n < size) {
+            n += std::fread(out + n, 1, size - n, file);
+            if (std::ferror(file)) {
+                throw std::runtime_error("Could not read the input file.");
+            }
+        }
+        return n;
+    }
+
+    ~FileSource() { std::fclose(file); }
+};
+
+class PlainDecoder : public Decoder {
+   public:
+    explicit PlainDecoder(std::unique_ptr<FileSource> source) : source_(std::move(source)) {}
+
+    std::size_t decode(char *out, std::size_t size) override { return source_->read(out, size); }
+
+   private:
+    std::unique_ptr<FileSource> source_;
+};
+
+class PlainEncoder : public Encoder {
+   public:
+    explicit PlainEncoder(std::FILE *file) : file_(file) {}
+    ~PlainEncoder() { std::fclose(file_); }
+
+    void encode(const char *data, std::size_t size) override {
+        if (std::fwrite(data, 1, size, file_) != size) {
+            throw std::runtime_error("Could not write to the output file.");
+        }
+    }
+
+    void finish() override {
+        if (std::fflush(file_) != 0) {
+            throw std::runtime_error("Could not write to the output file.");
+        }
+    }
+
+   private:
+    std::FILE *file_;
+};
+
+#ifdef PHYLO2VEC_WITH_ZLIB
+class GzipDecoder : public Decoder {
+   public:
+    explicit GzipDecoder(std::unique_ptr<FileSource> source)
+        : source_(std::move(source)), in_(COMPRESSED_BLOCK_SIZE), member_ended_(true) {
+        std::memset(&stream_, 0, sizeof(stream_));
+        // 15 + 32: maximum window size, automatic gzip/zlib header detection
+        if (inflateInit2(&stream_, 15 + 32) != Z_OK) {
+            throw std::runtime_error("Could not initialize zlib.");
+        }
+    }
+
+    ~GzipDecoder() { inflateEnd(&stream_); }
+
+    std::size_t decode(char *out, std::size_t size) override {
+        stream_.next_out = reinterpret_cast<Bytef *>(out);
+        stream_.avail_out = size;
+
+        while (stream_.avail_out > 0) {
+            if (stream_.avail_in == 0) {
+                std::size_t n = source_->read(in_.data(), in_.size());
+                if (n == 0) {
+                    if (!member_ended_) {
+                        throw std::runtime_error("Truncated gzip file.");
+                    }
+                    break;
+                }
+                stream_.next_in = reinterpret_cast<Bytef *>(in_.data());
+                stream_.avail_in = n;
+            }
+
+            member_ended_ = false;
+            int ret = inflate(&stream_, Z_NO_FLUSH);
+
+            if (ret == Z_STREAM_END) {
+                // Concatenated gzip files are valid gzip files
+                member_ended_ = true;
+                inflateReset(&stream_);
+            } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+                throw std::runtime_error(std::string("Invalid gzip data: ") +
+                                         (stream_.msg ? stream_.msg : "unknown error"));
+            }
+        }
+
+        return size - stream_.avail_out;
+    }
+
+   private:
+    std::unique_ptr<FileSource> source_;
+    std::vector<char> in_;
+    z_stream stream_;
+    bool member_ended_;
+};
+
+class GzipEncoder : public Encoder {
+   public:
+    explicit GzipEncoder(std::FILE *file) : file_(file), out_(COMPRESSED_BLOCK_SIZE) {
+        std::memset(&stream_, 0, sizeof(stream_));
+        // 15 + 16: maximum window size, gzip header
+        if (deflateInit2(&stream_, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                         Z_DEFAULT_STRATEGY) != Z_OK) {
+            throw std::runtime_error("Could not initialize zlib.");
+        }
+    }
+
+    ~GzipEncoder() {
+        deflateEnd(&stream_);
+        std::fclose(file_);
+    }
+
+    void encode(const char *data, std::size_t size) override {
+        stream_.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+        stream_.avail_in = size;
+        deflateAll(Z_NO_FLUSH);
+    }
+
+    void finish() override {
+        deflateAll(Z_FINISH);
+        if (std::fflush(file_) != 0) {
+            throw std::runtime_error("Could not write to the output file.");
+        }
+    }
+
+   private:
+    void deflateAll(int flush) {
+        int ret;
+        do {
+            stream_.next_out = reinterpret_cast<Bytef *>(out_.data());
+            stream_.avail_out = out_.size();
+
+            ret = deflate(&stream_, flush);
+            if (ret == Z_STREAM_ERROR) {
+                throw std::runtime_error("gzip compression failed.");
+            }
+
+            std::size_t n = out_.size() - stream_.avail_out;
+            if (std::fwrite(out_.data(), 1, n, file_) != n) {
+                throw std::runtime_error("Could not write to the output file.");
+            }
+        } while (stream_.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+    }
+
+    std::FILE *file_;
+    std::vector<char> out_;
+    z_stream stream_;
+};
+#endif  // PHYLO2VEC_WITH_ZLIB
+
+#ifdef PHYLO2VEC_WITH_ZSTD
+class ZstdDecoder : public Decoder {
+   public:
+    explicit ZstdDecoder(std::unique_ptr<FileSource> source)
+        : source_(std::move(source)),
+          stream_(ZSTD_createDStream()),
+          in_(ZSTD_DStreamInSize()),
+          input_({in_.data(), 0, 0}),
+          frame_ended_(true) {
+        if (stream_ == nullptr) {
+            throw std::runtime_error("Could not initialize zstd.");
+        }
+        ZSTD_initDStream(stream_);
+    }
+
+    ~ZstdDecoder() { ZSTD_freeDStream(stream_); }
+
+    std::size_t decode(char *out, std::size_t size) override {
+        ZSTD_outBuffer output = {out, size, 0};
+
+        while (output.pos < output.size) {
+            if (input_.pos == input_.size) {
+                std::size_t n = source_->read(in_.data(), in_.size());
+                if (n == 0) {
+                    if (!frame_ended_) {
+                        throw std::runtime_error("Truncated zstd file.");
+                    }
+                    break;
+                }
+                input_ = {in_.data(), n, 0};
+            }
+
+            std::size_t ret = ZSTD_decompressStream(stream_, &output, &input_);
+            if (ZSTD_isError(ret)) {
+                throw std::runtime_error(std::string("Invalid zstd data: ") +
+                                         ZSTD_getErrorName(ret));
+            }
+            // 0: the current frame is complete
+            frame_ended_ = ret == 0;
+        }
+
+        return output.pos;
+    }
+
+   private:
+    std::unique_ptr<FileSource> source_;
+    ZSTD_DStream *stream_;
+    std::vector<char> in_;
+    ZSTD_inBuffer input_;
+    bool frame_ended_;
+};
+
+class ZstdEncoder : public Encoder {
+   public:
+    explicit ZstdEncoder(std::FILE *file)
+        : file_(file), stream_(ZSTD_createCStream()), out_(ZSTD_CStreamOutSize()) {
+        if (stream_ == nullptr) {
+            throw std::runtime_error("Could not initialize zstd.");
+        }
+        ZSTD_initCStream(stream_, ZSTD_CLEVEL_DEFAULT);
+    }
+
+    ~ZstdEncoder() {
+        ZSTD_freeCStream(stream_);
+        std::fclose(file_);
+    }
+
+    void encode(const char *data, std::size_t size) override {
+        ZSTD_inBuffer input = {data, size, 0};
+        while (input.pos < input.size) {
+            compress(&input, ZSTD_e_continue);
+        }
+    }
+
+    void finish() override {
+        ZSTD_inBuffer input = {nullptr, 0, 0};
+        while (compress(&input, ZSTD_e_end) != 0) {
+        }
+        if (std::fflush(file_) != 0) {
+            throw std::runtime_error("Could not write to the output file.");
+        }
+    }
+
+   private:
+    std::size_t compress(ZSTD_inBuffer *input, ZSTD_EndDirective directive) {
+        ZSTD_outBuffer output = {out_.data(), out_.size(), 0};
+
+        std::size_t remaining = ZSTD_compressStream2(stream_, &output, input, directive);
+        if (ZSTD_isError(remaining)) {
+            throw std::runtime_error(std::string("zstd compression failed: ") +
+                                     ZSTD_getErrorName(remaining));
+        }
+
+        if (std::fwrite(out_.data(), 1, output.pos, file_) != output.pos) {
+            throw std::runtime_error("Could not write to the output file.");
+        }
+
+        return remaining;
+    }
+
+    std::FILE *file_;
+    ZSTD_CStream *stream_;
+    std::vector<char> out_;
+};
+#endif  // PHYLO2VEC_WITH_ZSTD
+
+DecompressingStreambuf::DecompressingStreambuf(const std::string &path, std::size_t chunk_size)
+    : chunks_(2, std::vector<char>(chunk_size)),
+      chunk_sizes_(2, 0),
+      free_chunks_({0, 1}),
+      current_chunk_(-1),
+      stop_(false) {
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        throw std::runtime_error("Could not open " + path + ".");
+    }
+
+    std::unique_ptr<FileSource> source(new FileSource{file, std::string(4, '\0'), 0});
+    source->prefix.resize(std::fread(&source->prefix[0], 1, 4, file));
+
+    compression_ = detectCompression(
+        reinterpret_cast<const unsigned char *>(source->prefix.data()), source->prefix.size());
+
+    if (compression_ == Compression::GZIP) {
+#ifdef PHYLO2VEC_WITH_ZLIB
+        decoder_.reset(new GzipDecoder(std::move(source)));
+#else
+        throw std::runtime_error(path + " is gzip-compressed, but zlib support is missing.");
+#endif
+    } else if (compression_ == Compression::ZSTD) {
+#ifdef PHYLO2VEC_WITH_ZSTD
+        decoder_.reset(new ZstdDecoder(std::move(source)));
+#else
+        throw std::runtime_error(path + " is zstd-compressed, but zstd support is missing.");
+#endif
+    } else {
+        decoder_.reset(new PlainDecoder(std::move(source)));
+    }
+
+    setg(nullptr, nullptr, nullptr);
+
+    producer_ = std::thread(&DecompressingStreambuf::produce, this);
+}
+
+DecompressingStreambuf::~DecompressingStreambuf() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    producer_.join();
+}
+
+void DecompressingStreambuf::produce() {
+    try {
+        while (true) {
+            int chunk;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return stop_ || !free_chunks_.empty(); });
+                if (stop_) {
+                    return;
+                }
+                chunk = free_chunks_.front();
+                free_chunks_.pop_front();
+            }
+
+            std::size_t size = decoder_->decode(chunks_[chunk].data(), chunks_[chunk].size());
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                chunk_sizes_[chunk] = size;
+                filled_chunks_.push_back(chunk);
+            }
+            cv_.notify_all();
+
+            // An empty chunk marks the end of the file
+            if (size == 0) {
+                return;
+            }
+        }
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            error_ = std::current_exception();
+        }
+        cv_.notify_all();
+    }
+}
+
+DecompressingStreambuf::int_type DecompressingStreambuf::underflow() {
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // Give the consumed chunk back to the producer
+    if (current_chunk_ >= 0) {
+        free_chunks_.push_back(current_chunk_);
+        current_chunk_ = -1;
+        cv_.notify_all();
+    }
+
+    cv_.wait(lock, [this] { return !filled_chunks_.empty() || error_; });
+
+    if (filled_chunks_.empty()) {
+        std::rethrow_exception(error_);
+    }
+
+    int chunk = filled_chunks_.front();
+    if (chunk_sizes_[chunk] == 0) {
+        // Keep the end-of-file marker for subsequent calls
+        return traits_type::eof();
+    }
+    filled_chunks_.pop_front();
+
+    current_chunk_ = chunk;
+    char *data = chunks_[chunk].data();
+    setg(data, data, data + chunk_sizes_[chunk]);
+
+    return traits_type::to_int_type(*gptr());
+}
+
+CompressingStreambuf::CompressingStreambuf(const std::string &path, Compression compression)
+    : buffer_(COMPRESSED_BLOCK_SIZE), closed_(false) {
+    // Owned here until an encoder has been constructed (its constructor may throw)
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> file(std::fopen(path.c_str(), "wb"),
+                                                            &std::fclose);
+    if (!file) {
+        throw std::runtime_error("Could not open " + path + " for writing.");
+    }
+
+    if (compression == Compression::GZIP) {
+#ifdef PHYLO2VEC_WITH_ZLIB
+        encoder_.reset(new GzipEncoder(file.get()));
+#else
+        throw std::runtime_error("Cannot write " + path + ": zlib support is missing.");
+#endif
+    } else if (compression == Compression::ZSTD) {
+#ifdef PHYLO2VEC_WITH_ZSTD
+        encoder_.reset(new ZstdEncoder(file.get()));
+#else
+        throw std::runtime_error("Cannot write " + path + ": zstd support is missing.");
+#endif
+    } else {
+        encoder_.reset(new PlainEncoder(file.get()));
+    }
+    file.release();
+
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+}
+
+CompressingStreambuf::~CompressingStreambuf() {
+    if (!closed_) {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+}
+
+void CompressingStreambuf::flushBuffer() {
+    encoder_->encode(pbase(), pptr() - pbase());
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+}
+
+CompressingStreambuf::int_type CompressingStreambuf::overflow(int_type c) {
+    flushBuffer();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+int CompressingStreambuf::sync() {
+    flushBuffer();
+    return 0;
+}
+
+void CompressingStreambuf::close() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+
+    flushBuffer();
+    encoder_->finish();
+}
+
+CompressedIfstream::CompressedIfstream(const std::string &path)
+    : std::istream(nullptr), buf_(path) {
+    rdbuf(&buf_);
+    exceptions(std::ios::badbit);
+}
+
+CompressedOfstream::CompressedOfstream(const std::string &path)
+    : CompressedOfstream(path, compressionFromPath(path)) {}
+
+CompressedOfstream::CompressedOfstream(const std::string &path, Compression compression)
+    : std::ostream(nullptr), buf_(path, compression) {
+    rdbuf(&buf_);
+    exceptions(std::ios::badbit);
+}
+
+void CompressedOfstream::close() {
+    flush();
+    buf_.close();
+}
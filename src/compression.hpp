@@ -0,0 +1,157 @@
+#ifndef COMPRESSION_HPP
+#define COMPRESSION_HPP
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Transparent gzip/zstd compression of input and output files
+ *
+ * gzip requires zlib (PHYLO2VEC_WITH_ZLIB) and zstd requires libzstd (PHYLO2VEC_WITH_ZSTD), both
+ * detected by CMake. Opening a compressed file without the corresponding library throws.
+ */
+
+enum class Compression { NONE, GZIP, ZSTD };
+
+/**
+ * @brief Detect the compression of a file from its first bytes
+ */
+Compression detectCompression(const unsigned char *bytes, std::size_t size);
+
+/**
+ * @brief Guess the compression of an output file from its extension (.gz or .zst)
+ */
+Compression compressionFromPath(const std::string &path);
+
+/**
+ * @brief Decoder of a compressed file: produces up to size bytes at a time
+ */
+class Decoder {
+   public:
+    virtual ~Decoder() {}
+
+    /**
+     * @return number of bytes written to out, 0 at the end of the file
+     */
+    virtual std::size_t decode(char *out, std::size_t size) = 0;
+};
+
+/**
+ * @brief Encoder of a compressed file
+ */
+class Encoder {
+   public:
+    virtual ~Encoder() {}
+    virtual void encode(const char *data, std::size_t size) = 0;
+    virtual void finish() = 0;
+};
+
+/**
+ * @brief Input stream buffer decompressing a file on a separate thread
+ * Two chunks are used alternately: while one is parsed by the consumer, the next one is
+ * decompressed, so that I/O, decompression and parsing overlap.
+ */
+class DecompressingStreambuf : public std::streambuf {
+   public:
+    /**
+     * @param path input file (plain, gzip or zstd, detected by magic bytes)
+     * @param chunk_size size of each chunk in bytes
+     */
+    explicit DecompressingStreambuf(const std::string &path, std::size_t chunk_size = 1 << 20);
+    ~DecompressingStreambuf();
+
+    Compression compression() const { return compression_; }
+
+   protected:
+    int_type underflow() override;
+
+   private:
+    void produce();
+
+    std::unique_ptr<Decoder> decoder_;
+    Compression compression_;
+
+    std::vector<std::vector<char>> chunks_;
+    std::vector<std::size_t> chunk_sizes_;
+    std::deque<int> free_chunks_;
+    std::deque<int> filled_chunks_;
+    int current_chunk_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_;
+    std::exception_ptr error_;
+    std::thread producer_;
+};
+
+/**
+ * @brief Output stream buffer compressing data to a file
+ */
+class CompressingStreambuf : public std::streambuf {
+   public:
+    /**
+     * @param path output file
+     * @param compression compression of the output file
+     */
+    CompressingStreambuf(const std::string &path, Compression compression);
+    ~CompressingStreambuf();
+
+    /**
+     * @brief Flush the remaining data and write the end of the compressed stream
+     */
+    void close();
+
+   protected:
+    int_type overflow(int_type c) override;
+    int sync() override;
+
+   private:
+    void flushBuffer();
+
+    std::unique_ptr<Encoder> encoder_;
+    std::vector<char> buffer_;
+    bool closed_;
+};
+
+/**
+ * @brief Input file stream reading plain, gzip or zstd files transparently
+ * Decompression errors throw (badbit is in the exception mask).
+ */
+class CompressedIfstream : public std::istream {
+   public:
+    explicit CompressedIfstream(const std::string &path);
+
+    Compression compression() const { return buf_.compression(); }
+
+   private:
+    DecompressingStreambuf buf_;
+};
+
+/**
+ * @brief Output file stream, compressed according to the file extension by default
+ */
+class CompressedOfstream : public std::ostream {
+   public:
+    explicit CompressedOfstream(const std::string &path);
+    CompressedOfstream(const std::string &path, Compression compression);
+
+    /**
+     * @brief Finish the compressed stream (also done on destruction)
+     */
+    void close();
+
+   private:
+    CompressingStreambuf buf_;
+};
+
+#endif  // COMPRESSION_HPP
@@ -0,0 +1,204 @@
+#include "distances.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "phylo2vec.hpp"
+
+// Size of the square blocks used to fill full matrices: D[i][j] and D[j][i] are written
+// together, so both blocks should stay in cache
+const int BLOCK_SIZE = 64;
+
+LCAIndex buildLCAIndex(const std::vector<std::array<int, 3>> &M) {
+    const int k = M.size();
+    const int num_nodes = 2 * k + 1;
+
+    LCAIndex index;
+    index.depths.assign(num_nodes, 0);
+    index.first_visits.assign(num_nodes, -1);
+
+    std::vector<std::array<int, 2>> children(num_nodes, {{-1, -1}});
+    for (const auto &row : M) {
+        children[row[0]] = {{row[1], row[2]}};
+    }
+
+    // Euler tour (iterative to support deep trees)
+    const int root = k == 0 ? 0 : M[0][0];
+
+    std::vector<int> tour;
+    tour.reserve(2 * num_nodes - 1);
+
+    std::vector<std::pair<int, int>> stack = {{root, 0}};
+    while (!stack.empty()) {
+        int node = stack.back().first;
+        int &next_child = stack.back().second;
+
+        if (next_child == 0) {
+            index.first_visits[node] = tour.size();
+        }
+        tour.push_back(node);
+
+        if (node > k && next_child < 2) {
+            int child = children[node][next_child++];
+            index.depths[child] = index.depths[node] + 1;
+            stack.emplace_back(child, 0);
+        } else {
+            stack.pop_back();
+        }
+    }
+
+    index.tour_size = tour.size();
+
+    index.logs.assign(index.tour_size + 1, 0);
+    for (int i = 2; i <= index.tour_size; ++i) {
+        index.logs[i] = index.logs[i / 2] + 1;
+    }
+
+    const int num_levels = index.logs[index.tour_size] + 1;
+
+    index.sparse_table.resize(num_levels * index.tour_size);
+    std::copy(tour.begin(), tour.end(), index.sparse_table.begin());
+
+    for (int level = 1; level < num_levels; ++level) {
+        const int *prev = index.sparse_table.data() + (level - 1) * index.tour_size;
+        int *curr = index.sparse_table.data() + level * index.tour_size;
+        const int half = 1 << (level - 1);
+
+        for (int i = 0; i + 2 * half <= index.tour_size; ++i) {
+            int left = prev[i], right = prev[i + half];
+            curr[i] = index.depths[left] <= index.depths[right] ? left : right;
+        }
+    }
+
+    return index;
+}
+
+int getLCA(const LCAIndex &index, int u, int v) {
+    int left = index.first_visits[u], right = index.first_visits[v];
+    if (left > right) {
+        std::swap(left, right);
+    }
+
+    const int level = index.logs[right - left + 1];
+    const int *row = index.sparse_table.data() + level * index.tour_size;
+
+    int a = row[left], b = row[right - (1 << level) + 1];
+    return index.depths[a] <= index.depths[b] ? a : b;
+}
+
+/**
+ * @brief Fill a cophenetic matrix given the depth of each node
+ * d(i, j) = depth(i) + depth(j) - 2 * depth(lca(i, j))
+ */
+template <typename T>
+void fillCopheneticDistances(const LCAIndex &index, const std::vector<T> &node_depths,
+                             int num_leaves, bool condensed, T *out) {
+    const std::size_t n = num_leaves;
+
+    if (condensed) {
+        // Rows of the upper triangle are contiguous
+        std::size_t idx = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            for (std::size_t j = i + 1; j < n; ++j) {
+                out[idx++] = node_depths[i] + node_depths[j] - 2 * node_depths[getLCA(index, i, j)];
+            }
+        }
+        return;
+    }
+
+    for (std::size_t ib = 0; ib < n; ib += BLOCK_SIZE) {
+        const std::size_t i_end = std::min(ib + BLOCK_SIZE, n);
+        for (std::size_t jb = ib; jb < n; jb += BLOCK_SIZE) {
+            const std::size_t j_end = std::min(jb + BLOCK_SIZE, n);
+            for (std::size_t i = ib; i < i_end; ++i) {
+                for (std::size_t j = std::max(jb, i + 1); j < j_end; ++j) {
+                    T d = node_depths[i] + node_depths[j] - 2 * node_depths[getLCA(index, i, j)];
+                    out[i * n + j] = d;
+                    out[j * n + i] = d;
+                }
+            }
+        }
+    }
+
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i * n + i] = 0;
+    }
+}
+
+std::size_t getMatrixSize(std::size_t num_leaves, bool condensed) {
+    return condensed ? num_leaves * (num_leaves - 1) / 2 : num_leaves * num_leaves;
+}
+
+std::vector<int> getCopheneticDistances(const std::vector<int> &v, bool condensed) {
+    check_v(v);
+
+    const int num_leaves = v.size() + 1;
+
+    LCAIndex index = buildLCAIndex(getAncestry(v));
+
+    std::vector<int> distances(getMatrixSize(num_leaves, condensed));
+    fillCopheneticDistances(index, index.depths, num_leaves, condensed, distances.data());
+
+    return distances;
+}
+
+std::vector<double> getCopheneticDistances(const std::vector<std::array<int, 3>> &M,
+                                           const std::vector<double> &branch_lengths,
+                                           bool condensed) {
+    const int num_leaves = M.size() + 1;
+
+    if (branch_lengths.size() != 2 * M.size() + 1) {
+        throw std::invalid_argument("There should be one branch length per node.");
+    }
+
+    LCAIndex index = buildLCAIndex(M);
+
+    // Rows of M are stored from the root: parents are visited before their children
+    std::vector<double> node_depths(branch_lengths.size(), 0.0);
+    for (const auto &row : M) {
+        node_depths[row[1]] = node_depths[row[0]] + branch_lengths[row[1]];
+        node_depths[row[2]] = node_depths[row[0]] + branch_lengths[row[2]];
+    }
+
+    std::vector<double> distances(getMatrixSize(num_leaves, condensed));
+    fillCopheneticDistances(index, node_depths, num_leaves, condensed, distances.data());
+
+    return distances;
+}
+
+std::vector<std::vector<int>> getCopheneticDistances(const std::vector<std::vector<int>> &vs,
+                                                     bool condensed) {
+    // Validate everything first: exceptions cannot leave a parallel region
+    for (const auto &v : vs) {
+        check_v(v);
+    }
+
+    std::vector<std::vector<int>> distances(vs.size());
+
+#pragma omp parallel for schedule(dynamic)
+    for (std::size_t i = 0; i < vs.size(); ++i) {
+        distances[i] = getCopheneticDistances(vs[i], condensed);
+    }
+
+    return distances;
+}
+
+std::vector<std::vector<double>> getCopheneticDistances(const std::vector<std::string> &newicks,
+                                                        bool condensed) {
+    std::vector<std::vector<std::array<int, 3>>> ancestries(newicks.size());
+    std::vector<std::vector<double>> branch_lengths(newicks.size());
+
+    // Parse sequentially: exceptions cannot leave a parallel region
+    for (std::size_t i = 0; i < newicks.size(); ++i) {
+        ancestries[i] = getAncestryFromNewick(newicks[i], branch_lengths[i]);
+    }
+
+    std::vector<std::vector<double>> distances(newicks.size());
+
+#pragma omp parallel for schedule(dynamic)
+    for (std::size_t i = 0; i < newicks.size(); ++i) {
+        distances[i] = getCopheneticDistances(ancestries[i], branch_lengths[i], condensed);
+    }
+
+    return distances;
+}
@@ -0,0 +1,75 @@
+#ifndef DISTANCES_HPP
+#define DISTANCES_HPP
+
+#include <array>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Lowest common ancestor index of a tree (Euler tour + sparse table)
+ * depths: topological depth of each node
+ * first_visits: position of the first visit of each node in the Euler tour
+ * sparse_table: sparse_table[level * tour_size + i] is the shallowest node of the tour
+ * between positions i and i + 2^level - 1
+ * logs: logs[i] = floor(log2(i))
+ */
+struct LCAIndex {
+    std::vector<int> depths;
+    std::vector<int> first_visits;
+    std::vector<int> sparse_table;
+    std::vector<int> logs;
+    int tour_size;
+};
+
+/**
+ * @brief Build the LCA index of a tree in O(n log n)
+ *
+ * @param M cf. getAncestry
+ */
+LCAIndex buildLCAIndex(const std::vector<std::array<int, 3>> &M);
+
+/**
+ * @brief Get the lowest common ancestor of two nodes in O(1)
+ *
+ * @param index cf. buildLCAIndex
+ * @param u first node
+ * @param v second node
+ */
+int getLCA(const LCAIndex &index, int u, int v);
+
+/**
+ * @brief Get the cophenetic (leaf-to-leaf path length) matrix of a tree, in number of edges
+ *
+ * @param v Phylo2Vec vector (k + 1 leaves)
+ * @param condensed if true, only store the upper triangle (i < j) row by row (cf. scipy's
+ * squareform), otherwise store the full (k + 1) x (k + 1) matrix row by row
+ */
+std::vector<int> getCopheneticDistances(const std::vector<int> &v, bool condensed = false);
+
+/**
+ * @brief Get the cophenetic (patristic) matrix of a tree with branch lengths
+ *
+ * @param M cf. getAncestry or getAncestryFromNewick
+ * @param branch_lengths length of the branch above each node
+ * @param condensed cf. getCopheneticDistances
+ */
+std::vector<double> getCopheneticDistances(const std::vector<std::array<int, 3>> &M,
+                                           const std::vector<double> &branch_lengths,
+                                           bool condensed = false);
+
+/**
+ * @brief Batch version of getCopheneticDistances for Phylo2Vec vectors
+ * Trees are processed in parallel (if compiled with OpenMP).
+ */
+std::vector<std::vector<int>> getCopheneticDistances(const std::vector<std::vector<int>> &vs,
+                                                     bool condensed = false);
+
+/**
+ * @brief Batch version of getCopheneticDistances for Newick strings with branch lengths
+ * Leaves should be integers (cf. integerizeChildNodes). Trees are processed in parallel (if
+ * compiled with OpenMP).
+ */
+std::vector<std::vector<double>> getCopheneticDistances(const std::vector<std::string> &newicks,
+                                                        bool condensed = false);
+
+#endif  // DISTANCES_HPP
@@ -0,0 +1,248 @@
+#include "enumeration.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#include "phylo2vec.hpp"
+
+namespace {
+
+// Arbitrary-precision unsigned integers: little-endian base 10^9 limbs
+typedef std::vector<uint32_t> BigInt;
+
+const uint32_t LIMB_BASE = 1000000000;
+
+void mulAdd(BigInt &x, uint32_t factor, uint32_t term) {
+    uint64_t carry = term;
+    for (uint32_t &limb : x) {
+        const uint64_t value = static_cast<uint64_t>(limb) * factor + carry;
+        limb = value % LIMB_BASE;
+        carry = value / LIMB_BASE;
+    }
+    while (carry > 0) {
+        x.push_back(carry % LIMB_BASE);
+        carry /= LIMB_BASE;
+    }
+}
+
+uint32_t divMod(BigInt &x, uint32_t divisor) {
+    uint64_t remainder = 0;
+    for (std::size_t i = x.size(); i-- > 0;) {
+        const uint64_t value = remainder * LIMB_BASE + x[i];
+        x[i] = value / divisor;
+        remainder = value % divisor;
+    }
+    while (!x.empty() && x.back() == 0) {
+        x.pop_back();
+    }
+    return remainder;
+}
+
+std::string bigToString(const BigInt &x) {
+    if (x.empty()) {
+        return "0";
+    }
+    std::ostringstream oss;
+    oss << x.back();
+    for (std::size_t i = x.size() - 1; i-- > 0;) {
+        const std::string limb = std::to_string(x[i]);
+        oss << std::string(9 - limb.size(), '0') << limb;
+    }
+    return oss.str();
+}
+
+BigInt bigFromString(const std::string &str) {
+    if (str.empty() ||
+        !std::all_of(str.begin(), str.end(), [](char c) { return std::isdigit(c) != 0; })) {
+        std::ostringstream oss;
+        oss << "Invalid rank: '" << str << "'. Expected a non-negative decimal integer.";
+        throw std::invalid_argument(oss.str());
+    }
+    BigInt x;
+    for (char c : str) {
+        mulAdd(x, 10, c - '0');
+    }
+    while (!x.empty() && x.back() == 0) {
+        x.pop_back();
+    }
+    return x;
+}
+
+}  // namespace
+
+uint128 getNumTrees(int k) {
+    if (k < 0) {
+        throw std::invalid_argument("k should be non-negative.");
+    }
+    const uint128 max_value = std::numeric_limits<uint128>::max();
+    uint128 num_trees = 1;
+    for (int i = 1; i < k; ++i) {
+        const unsigned int radix = 2 * i + 1;
+        if (num_trees > max_value / radix) {
+            std::ostringstream oss;
+            oss << "The number of trees with " << k + 1
+                << " leaves does not fit in 128 bits. Use rankToString/unrankFromString instead.";
+            throw std::overflow_error(oss.str());
+        }
+        num_trees *= radix;
+    }
+    return num_trees;
+}
+
+uint128 rank(const std::vector<int> &v) {
+    check_v(v);
+    // Throws if the ranks do not fit in 128 bits
+    getNumTrees(v.size());
+
+    uint128 r = 0;
+    for (std::size_t i = 0; i < v.size(); ++i) {
+        r = r * (2 * i + 1) + v[i];
+    }
+    return r;
+}
+
+std::vector<int> unrank(uint128 r, int k) {
+    if (r >= getNumTrees(k)) {
+        std::ostringstream oss;
+        oss << "Rank " << toString(r) << " is out of range for trees with " << k + 1
+            << " leaves.";
+        throw std::out_of_range(oss.str());
+    }
+
+    std::vector<int> v(k);
+    for (int i = k - 1; i >= 0; --i) {
+        const unsigned int radix = 2 * i + 1;
+        v[i] = r % radix;
+        r /= radix;
+    }
+    return v;
+}
+
+std::string rankToString(const std::vector<int> &v) {
+    check_v(v);
+
+    BigInt r;
+    for (std::size_t i = 0; i < v.size(); ++i) {
+        mulAdd(r, 2 * i + 1, v[i]);
+    }
+    while (!r.empty() && r.back() == 0) {
+        r.pop_back();
+    }
+    return bigToString(r);
+}
+
+std::vector<int> unrankFromString(const std::string &str, int k) {
+    if (k < 0) {
+        throw std::invalid_argument("k should be non-negative.");
+    }
+    BigInt r = bigFromString(str);
+
+    std::vector<int> v(k);
+    for (int i = k - 1; i >= 0; --i) {
+        v[i] = divMod(r, 2 * i + 1);
+    }
+    if (!r.empty()) {
+        std::ostringstream oss;
+        oss << "Rank " << str << " is out of range for trees with " << k + 1 << " leaves.";
+        throw std::out_of_range(oss.str());
+    }
+    return v;
+}
+
+std::string toString(uint128 value) {
+    if (value == 0) {
+        return "0";
+    }
+    std::string digits;
+    while (value > 0) {
+        digits.push_back('0' + static_cast<int>(value % 10));
+        value /= 10;
+    }
+    std::reverse(digits.begin(), digits.end());
+    return digits;
+}
+
+TreeEnumerator::TreeEnumerator(int k) : TreeEnumerator(k, 0, getNumTrees(k)) {}
+
+TreeEnumerator::TreeEnumerator(int k, uint128 begin, uint128 end)
+    : k_(k), rank_(begin), end_(std::min(end, getNumTrees(k))), started_(false), pairs_(k) {
+    if (begin < end_) {
+        v_ = unrank(begin, k);
+    }
+}
+
+bool TreeEnumerator::next() {
+    if (!started_) {
+        started_ = true;
+        if (rank_ >= end_) {
+            return false;
+        }
+        updatePairs(0);
+        return true;
+    }
+
+    if (rank_ + 1 >= end_) {
+        return false;
+    }
+
+    // Odometer increment: v[i] is a digit in radix 2i + 1
+    int i = k_ - 1;
+    while (v_[i] == 2 * i) {
+        v_[i] = 0;
+        --i;
+    }
+    ++v_[i];
+    ++rank_;
+
+    updatePairs(i);
+    return true;
+}
+
+void TreeEnumerator::updatePairs(int from) {
+    for (int j = from; j < k_; ++j) {
+        if (j == 0) {
+            pairs_[j].clear();
+        } else {
+            pairs_[j] = pairs_[j - 1];
+        }
+        addPair(pairs_[j], j, v_[j]);
+    }
+
+    ancestry_ = k_ > 0 ? getAncestryFromPairs(pairs_[k_ - 1]) : std::vector<std::array<int, 3>>();
+}
+
+std::vector<std::pair<uint128, uint128>> splitRanks(int k, int num_parts) {
+    if (num_parts <= 0) {
+        throw std::invalid_argument("num_parts should be positive.");
+    }
+
+    const uint128 num_trees = getNumTrees(k);
+    const uint128 quotient = num_trees / num_parts;
+    const uint128 remainder = num_trees % num_parts;
+
+    std::vector<std::pair<uint128, uint128>> ranges(num_parts);
+    uint128 begin = 0;
+    for (int i = 0; i < num_parts; ++i) {
+        const uint128 end = begin + quotient + (static_cast<uint128>(i) < remainder ? 1 : 0);
+        ranges[i] = std::make_pair(begin, end);
+        begin = end;
+    }
+    return ranges;
+}
+
+void enumerateTrees(int k, int num_parts,
+                    const std::function<void(int, const TreeEnumerator &)> &callback) {
+    const std::vector<std::pair<uint128, uint128>> ranges = splitRanks(k, num_parts);
+
+#pragma omp parallel for schedule(dynamic)
+    for (int part = 0; part < num_parts; ++part) {
+        TreeEnumerator enumerator(k, ranges[part].first, ranges[part].second);
+        while (enumerator.next()) {
+            callback(part, enumerator);
+        }
+    }
+}
@@ -0,0 +1,116 @@
+#ifndef ENUMERATION_HPP
+#define ENUMERATION_HPP
+
+#include <array>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Bijection between Phylo2Vec vectors and integers, and exhaustive enumeration of trees
+ *
+ * Since 0 <= v[i] <= 2i, vectors of size k (k + 1 leaves) are the digits of a mixed-radix number
+ * (radix 2i + 1 for v[i], v[0] being the most significant digit): rank(v) is in
+ * [0, (2k - 1)!!) and ranks follow the lexicographic order of the vectors.
+ */
+
+typedef unsigned __int128 uint128;
+
+/**
+ * @brief Number of trees with k + 1 leaves: (2k - 1)!!
+ * Throws std::overflow_error if it does not fit in 128 bits (k > 28)
+ */
+uint128 getNumTrees(int k);
+
+/**
+ * @brief Rank of a Phylo2Vec vector (k <= 28)
+ */
+uint128 rank(const std::vector<int> &v);
+
+/**
+ * @brief Phylo2Vec vector of size k with a given rank
+ */
+std::vector<int> unrank(uint128 r, int k);
+
+/**
+ * @brief Rank of a Phylo2Vec vector of any size, as a decimal string
+ */
+std::string rankToString(const std::vector<int> &v);
+
+/**
+ * @brief Phylo2Vec vector of size k with a given rank (decimal string, any size)
+ */
+std::vector<int> unrankFromString(const std::string &r, int k);
+
+/**
+ * @brief Decimal representation of a 128-bit integer
+ */
+std::string toString(uint128 value);
+
+/**
+ * @brief Enumerate trees with k + 1 leaves in lexicographic order of their vectors
+ *
+ * Each step increments v like an odometer. The pairs of each prefix of v are cached (cf.
+ * addPair), so that only the pairs of the changed entries are recomputed, and the ancestry is
+ * rebuilt from the pairs in O(k) instead of calling getAncestry.
+ *
+ * Usage:
+ *     TreeEnumerator enumerator(k);
+ *     while (enumerator.next()) {
+ *         // use enumerator.v(), enumerator.ancestry()
+ *     }
+ */
+class TreeEnumerator {
+   public:
+    /**
+     * @param k number of leaves - 1
+     * @param begin rank of the first tree
+     * @param end rank after the last tree (default: all trees)
+     */
+    explicit TreeEnumerator(int k);
+    TreeEnumerator(int k, uint128 begin, uint128 end);
+
+    /**
+     * @brief Move to the next tree
+     *
+     * @return false if there are no trees left
+     */
+    bool next();
+
+    const std::vector<int> &v() const { return v_; }
+    const std::vector<std::array<int, 3>> &ancestry() const { return ancestry_; }
+    uint128 rank() const { return rank_; }
+
+   private:
+    void updatePairs(int from);
+
+    int k_;
+    uint128 rank_;
+    uint128 end_;
+    bool started_;
+    std::vector<int> v_;
+    // pairs_[j]: pairs of v[0..j]
+    std::vector<std::vector<std::pair<int, int>>> pairs_;
+    std::vector<std::array<int, 3>> ancestry_;
+};
+
+/**
+ * @brief Split the ranks of all trees with k + 1 leaves into num_parts balanced ranges
+ *
+ * @return std::vector<std::pair<uint128, uint128>> [begin, end) of each range
+ */
+std::vector<std::pair<uint128, uint128>> splitRanks(int k, int num_parts);
+
+/**
+ * @brief Enumerate all trees with k + 1 leaves in parallel (if compiled with OpenMP)
+ * The callback is called concurrently: it should only write to thread-specific data.
+ *
+ * @param k number of leaves - 1
+ * @param num_parts number of rank ranges processed independently
+ * @param callback called with the index of the range and the enumerator positioned on a tree
+ */
+void enumerateTrees(int k, int num_parts,
+                    const std::function<void(int, const TreeEnumerator &)> &callback);
+
+#endif  // ENUMERATION_HPP
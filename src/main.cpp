@@ -1,7 +1,18 @@
+#include <algorithm>
+#include <cctype>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
 
+#include "cache.hpp"
+#include "compression.hpp"
 #include "cxxopts.hpp"
+#include "nexus.hpp"
+#include "npy.hpp"
 #include "phylo2vec.hpp"
+#include "shard.hpp"
+#include "stats.hpp"
 
 cxxopts::Options get_options() {
     // Parse options with CXXOpts
@@ -14,7 +25,18 @@ cxxopts::Options get_options() {
         ("toNewick", "Convert to Newick format. Example input: 0 1 4", cxxopts::value<std::vector<int>>())
         ("toVector", "Convert to integer vector. Example input: \"(((2,1)4,0)5,3)6;\"", cxxopts::value<std::string>())
         ("with_mapping", "For Newicks that do not only contain digits, to use with toVector. Example input: \"(((((((tip_0:1.44,tip_1:1.44)8042:0.46,(tip_2:1.5,tip_3:1.5)8043:0.4)8044:0.3,(tip_4:1.51,tip_5:1.51)8045:0.69)8046:0.4,tip_6:2.6)8047:1.05,tip_7:3.65)8048:0.5,(((tip_8:0.72,tip_9:0.72)8049:0.28,tip_10:1)8050:1.56,tip_11:2.56)8051:1.59)8052:1.96,tip_12:6.11)8053:0;\"", cxxopts::value<bool>()->default_value("false"))
-        ("num_leaves", "Number of leaves (optional, but recommended when using toVector)", cxxopts::value<int>());
+        ("num_leaves", "Number of leaves (optional, but recommended when using toVector)", cxxopts::value<int>())
+        ("reroot", "Root trees before toVector, nexus or shard: none, resolve (root trifurcation of unrooted trees), leaf (see outgroup) or midpoint", cxxopts::value<std::string>()->default_value("none"))
+        ("outgroup", "Leaf (taxon name with with_mapping, nexus or shard) on whose branch to root trees, with --reroot leaf", cxxopts::value<std::string>())
+        ("stats", "Compute tree-shape statistics for a file of integer vectors (one per line). Output: CSV", cxxopts::value<std::string>())
+        ("nexus", "Convert all trees of a NEXUS file (e.g., MrBayes/BEAST posterior) to integer vectors", cxxopts::value<std::string>())
+        ("output", "Output file for nexus, shard and merge: integer vectors (one per line), or a NumPy array if the file ends with .npy", cxxopts::value<std::string>())
+        ("partition", "Split the trees of a NEXUS file into shards of similar size (see num_shards, manifest)", cxxopts::value<std::string>())
+        ("num_shards", "Number of shards for partition", cxxopts::value<int>()->default_value("1"))
+        ("manifest", "Shard manifest written by partition and read by shard and merge (default for partition: <file>.shards)", cxxopts::value<std::string>())
+        ("shard", "Convert the trees of one shard (by id) of a manifest. Writes <output> with .shard<id> before its extension", cxxopts::value<int>())
+        ("merge", "Merge the outputs of all shards of a manifest into output, in the original order")
+        ("cache_mb", "Memory budget (MiB) of a cache of converted topologies for nexus, useful when trees repeat (0: disabled)", cxxopts::value<int>()->default_value("0"));
     // clang-format on
 
     options.positional_help("toNewick toVector");
@@ -42,11 +64,12 @@ void doToNewick(std::vector<int> v) {
     std::cout << "Newick string: " << newick << std::endl;
 }
 
-void doToVector(std::string newick, int num_leaves, bool with_mapping) {
+void doToVector(std::string newick, int num_leaves, bool with_mapping, RerootMethod reroot_method,
+                const std::string& outgroup) {
     std::vector<int> converted_v;
 
     if (with_mapping) {
-        Newick2VResult tmp = newick2vWithMapping(newick, num_leaves);
+        Newick2VResult tmp = newick2vWithMapping(newick, num_leaves, reroot_method, outgroup);
         converted_v = tmp.v;
 
         std::map<int, std::string> converted_mapping = convertMapping(tmp.mapping);
@@ -58,7 +81,7 @@ void doToVector(std::string newick, int num_leaves, bool with_mapping) {
             std::cout << elem.first << "->" << elem.second << std::endl;
         }
     } else {
-        converted_v = newick2v(newick, num_leaves).v;
+        converted_v = newick2v(newick, num_leaves, reroot_method, outgroup).v;
     }
 
     std::cout << "Integer vector: ";
@@ -68,7 +91,261 @@ void doToVector(std::string newick, int num_leaves, bool with_mapping) {
     std::cout << std::endl;
 }
 
-int main(int argc, char* argv[]) {
+/**
+ * @brief Parse a line of whitespace-separated integers into v
+ *
+ * @return false if the line contains anything else than integers
+ */
+bool parseVector(const std::string& line, std::vector<int>& v) {
+    v.clear();
+    std::istringstream iss(line);
+    while (iss >> std::ws && !iss.eof()) {
+        int val;
+        // Fails on non-integers ("x", "-") and on values out of the range of int
+        if (!(iss >> val)) {
+            return false;
+        }
+        // The whole token should be read ("1x" is not an integer)
+        if (!iss.eof() && !std::isspace(iss.peek())) {
+            return false;
+        }
+        v.push_back(val);
+    }
+
+    return true;
+}
+
+int doStats(const std::string& path) {
+    CompressedIfstream file(path);
+
+    std::vector<std::vector<int>> vs;
+    std::string line;
+    std::vector<int> v;
+    std::size_t line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        if (!parseVector(line, v)) {
+            std::ostringstream oss;
+            oss << "Invalid vector at line " << line_number << " of " << path
+                << ": expected whitespace-separated integers.";
+            throw std::invalid_argument(oss.str());
+        }
+        vs.push_back(v);
+    }
+
+    TreeStatsBatch batch = getTreeStats(vs);
+
+    std::cout << "sackin,colless,cherries,height,depths" << std::endl;
+    for (std::size_t i = 0; i < vs.size(); ++i) {
+        std::cout << batch.sackin[i] << "," << batch.colless[i] << "," << batch.cherries[i] << ","
+                  << batch.height[i] << ",";
+        for (std::size_t j = batch.depth_offsets[i]; j < batch.depth_offsets[i + 1]; ++j) {
+            std::cout << batch.depths[j] << (j + 1 < batch.depth_offsets[i + 1] ? " " : "");
+        }
+        std::cout << "\n";
+    }
+
+    return 0;
+}
+
+bool endsWith(const std::string& str, const std::string& suffix) {
+    return str.size() >= suffix.size() &&
+           str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/**
+ * @brief Integer vectors written one per line (text, possibly compressed, or stdout if path is
+ * empty), or as a NumPy array if path ends with .npy
+ */
+class VectorOutput {
+   public:
+    explicit VectorOutput(const std::string& path) : path_(path) {
+        if (!path.empty() && !isNpy()) {
+            text_file_.reset(new CompressedOfstream(path));
+        }
+    }
+
+    bool isNpy() const { return endsWith(path_, ".npy"); }
+
+    void write(const std::vector<int>& v) {
+        if (isNpy()) {
+            if (!npy_) {
+                npy_.reset(new NpyWriter(path_, {v.size()}));
+            }
+            npy_->write(v);
+        } else {
+            std::ostream& out = text_file_ ? *text_file_ : std::cout;
+            for (std::size_t i = 0; i < v.size(); ++i) {
+                out << v[i] << (i + 1 < v.size() ? " " : "");
+            }
+            out << "\n";
+        }
+    }
+
+    /**
+     * @param vector_size size of the vectors, to write an empty NumPy array if needed
+     */
+    void close(std::size_t vector_size) {
+        if (isNpy() && !npy_) {
+            npy_.reset(new NpyWriter(path_, {vector_size}));
+        }
+        if (npy_) {
+            npy_->close();
+        }
+        if (text_file_) {
+            text_file_->close();
+        }
+    }
+
+   private:
+    std::string path_;
+    std::unique_ptr<NpyWriter> npy_;
+    std::unique_ptr<CompressedOfstream> text_file_;
+};
+
+void printMapping(const std::vector<std::string>& taxa) {
+    std::cout << "Number of leaves: " << taxa.size() << std::endl;
+    std::cout << "Mapping:" << std::endl;
+    for (std::size_t i = 0; i < taxa.size(); ++i) {
+        std::cout << i << "->" << taxa[i] << std::endl;
+    }
+}
+
+/**
+ * @brief Leaf of the outgroup taxon in a NEXUS taxon table (-1 unless rooting on a leaf)
+ */
+int findOutgroup(const std::vector<std::string>& taxa, RerootMethod reroot_method,
+                 const std::string& outgroup) {
+    if (reroot_method != RerootMethod::LEAF) {
+        return -1;
+    }
+
+    auto it = std::find(taxa.begin(), taxa.end(), outgroup);
+    if (it == taxa.end()) {
+        throw std::invalid_argument("Unknown outgroup taxon: '" + outgroup + "'.");
+    }
+    return it - taxa.begin();
+}
+
+void printCacheStats(const ConversionCache& cache) {
+    if (!cache.bypass()) {
+        CacheStats stats = cache.stats();
+        std::cerr << "Cache: " << stats.hits << " hits, " << stats.misses << " misses, "
+                  << stats.evictions << " evictions." << std::endl;
+    }
+}
+
+int doNexus(const std::string& path, const std::string& output, int cache_mb,
+            RerootMethod reroot_method, const std::string& outgroup) {
+    CompressedIfstream file(path);
+    NexusReader reader(file);
+
+    ConversionCache cache(static_cast<std::size_t>(std::max(cache_mb, 0)) << 20);
+    cache.setBypass(cache_mb <= 0);
+
+    VectorOutput out(output);
+
+    NexusTree tree;
+    std::size_t num_trees = 0;
+    int outgroup_leaf = -1;
+    while (reader.next(tree)) {
+        if (num_trees == 0) {
+            // The taxon table is complete once the first tree has been read
+            outgroup_leaf = findOutgroup(reader.taxa(), reroot_method, outgroup);
+            printMapping(reader.taxa());
+            if (output.empty()) {
+                std::cout << "Integer vectors:" << std::endl;
+            }
+        }
+
+        out.write(cache.fromNewick(tree.newick, reroot_method, outgroup_leaf));
+        ++num_trees;
+    }
+
+    out.close(reader.taxa().empty() ? 0 : reader.taxa().size() - 1);
+
+    std::cerr << "Converted " << num_trees << " trees." << std::endl;
+    printCacheStats(cache);
+
+    return 0;
+}
+
+ShardManifest loadManifest(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Could not open " + path + ".");
+    }
+    return readManifest(file);
+}
+
+int doPartition(const std::string& path, int num_shards, const std::string& manifest_path) {
+    ShardManifest manifest = partitionTrees(path, num_shards);
+
+    std::ofstream file(manifest_path);
+    if (!file) {
+        throw std::runtime_error("Could not open " + manifest_path + " for writing.");
+    }
+    writeManifest(manifest, file);
+
+    for (std::size_t i = 0; i < manifest.shards.size(); ++i) {
+        std::cout << "Shard " << i << ": bytes [" << manifest.shards[i].first << ", "
+                  << manifest.shards[i].second << ")" << std::endl;
+    }
+    std::cerr << "Wrote " << manifest_path << "." << std::endl;
+
+    return 0;
+}
+
+int doShard(const std::string& manifest_path, int shard_id, const std::string& output,
+            int cache_mb, RerootMethod reroot_method, const std::string& outgroup) {
+    if (output.empty()) {
+        throw std::invalid_argument("--output is required to process a shard.");
+    }
+
+    ShardManifest manifest = loadManifest(manifest_path);
+    ShardReader reader(manifest, shard_id);
+    const int outgroup_leaf = findOutgroup(manifest.taxa, reroot_method, outgroup);
+
+    ConversionCache cache(static_cast<std::size_t>(std::max(cache_mb, 0)) << 20);
+    cache.setBypass(cache_mb <= 0);
+
+    const std::string shard_output = getShardPath(output, shard_id);
+    VectorOutput out(shard_output);
+
+    NexusTree tree;
+    std::size_t num_trees = 0;
+    while (reader.next(tree)) {
+        out.write(cache.fromNewick(tree.newick, reroot_method, outgroup_leaf));
+        ++num_trees;
+    }
+
+    out.close(manifest.taxa.empty() ? 0 : manifest.taxa.size() - 1);
+
+    std::cerr << "Converted " << num_trees << " trees to " << shard_output << "." << std::endl;
+    printCacheStats(cache);
+
+    return 0;
+}
+
+int doMerge(const std::string& manifest_path, const std::string& output) {
+    if (output.empty()) {
+        throw std::invalid_argument("--output is required to merge shards.");
+    }
+
+    ShardManifest manifest = loadManifest(manifest_path);
+    std::size_t num_trees = mergeShardOutputs(manifest, output);
+
+    printMapping(manifest.taxa);
+    std::cerr << "Merged " << num_trees << " trees from " << manifest.shards.size()
+              << " shards." << std::endl;
+
+    return 0;
+}
+
+int run(int argc, char* argv[]) {
     cxxopts::Options options = get_options();
 
     auto result = options.parse(argc, argv);
@@ -78,6 +355,19 @@ int main(int argc, char* argv[]) {
         return 0;
     }
 
+    RerootMethod reroot_method = parseRerootMethod(result["reroot"].as<std::string>());
+    std::string outgroup = result.count("outgroup") ? result["outgroup"].as<std::string>() : "";
+    if (result.count("outgroup") && reroot_method != RerootMethod::LEAF) {
+        throw std::invalid_argument("--outgroup is only used with --reroot leaf.");
+    }
+    if (reroot_method == RerootMethod::LEAF && !result.count("outgroup")) {
+        throw std::invalid_argument("--reroot leaf requires --outgroup.");
+    }
+    if (reroot_method != RerootMethod::NONE && !result.count("toVector") &&
+        !result.count("nexus") && !(result.count("shard") && !result.count("merge"))) {
+        throw std::invalid_argument("--reroot is only used with toVector, nexus and shard.");
+    }
+
     if (result.count("toNewick")) {
         std::vector<int> v = result["toNewick"].as<std::vector<int>>();
         doToNewick(v);
@@ -86,11 +376,42 @@ int main(int argc, char* argv[]) {
         int num_leaves = result.count("num_leaves") ? result["num_leaves"].as<int>() : -1;
 
         bool with_mapping = result["with_mapping"].as<bool>();
-        doToVector(newick, num_leaves, with_mapping);
+        doToVector(newick, num_leaves, with_mapping, reroot_method, outgroup);
+    } else if (result.count("stats")) {
+        return doStats(result["stats"].as<std::string>());
+    } else if (result.count("nexus")) {
+        std::string output = result.count("output") ? result["output"].as<std::string>() : "";
+        return doNexus(result["nexus"].as<std::string>(), output, result["cache_mb"].as<int>(),
+                       reroot_method, outgroup);
+    } else if (result.count("partition")) {
+        std::string path = result["partition"].as<std::string>();
+        std::string manifest =
+            result.count("manifest") ? result["manifest"].as<std::string>() : path + ".shards";
+        return doPartition(path, result["num_shards"].as<int>(), manifest);
+    } else if (result.count("shard") || result.count("merge")) {
+        if (!result.count("manifest")) {
+            throw std::invalid_argument("--manifest is required to process or merge shards.");
+        }
+        std::string manifest = result["manifest"].as<std::string>();
+        std::string output = result.count("output") ? result["output"].as<std::string>() : "";
+        if (result.count("merge")) {
+            return doMerge(manifest, output);
+        }
+        return doShard(manifest, result["shard"].as<int>(), output, result["cache_mb"].as<int>(),
+                       reroot_method, outgroup);
     } else {
         std::cerr << "Invalid arguments. Use --help for usage information." << std::endl;
         return 1;
     }
 
     return 0;
-}
\ No newline at end of file
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        return run(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,272 @@
+#include "nexus.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <stdexcept>
+
+std::string toLower(std::string str) {
+    std::transform(str.begin(), str.end(), str.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    return str;
+}
+
+/**
+ * @brief Split a NEXUS statement into words, removing quotes ('' is an escaped quote)
+ *
+ * @param str statement
+ * @param separator additional separator (besides whitespace), or 0
+ * @return std::vector<std::string> words (empty words between separators are kept)
+ */
+std::vector<std::string> splitWords(const std::string &str, char separator = 0) {
+    std::vector<std::string> words;
+    std::string word;
+    bool in_word = false;
+
+    for (std::size_t i = 0; i < str.size(); ++i) {
+        char c = str[i];
+        if (c == '\'') {
+            in_word = true;
+            for (++i; i < str.size(); ++i) {
+                if (str[i] == '\'') {
+                    if (i + 1 < str.size() && str[i + 1] == '\'') {
+                        word += '\'';
+                        ++i;
+                    } else {
+                        break;
+                    }
+                } else {
+                    word += str[i];
+                }
+            }
+        } else if (c == separator) {
+            words.push_back(word);
+            word.clear();
+            in_word = false;
+            // Keep an empty word so that "a, b" and "a b" can be told apart
+            words.push_back("");
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            if (in_word) {
+                words.push_back(word);
+                word.clear();
+                in_word = false;
+            }
+        } else {
+            word += c;
+            in_word = true;
+        }
+    }
+
+    if (in_word) {
+        words.push_back(word);
+    }
+
+    return words;
+}
+
+NexusReader::NexusReader(std::istream &in) : in_(in), has_taxa_(false) {
+    std::string header;
+    while (header.empty() && in_ >> header) {
+    }
+
+    if (toLower(header) != "#nexus") {
+        throw std::runtime_error("Invalid NEXUS file: missing #NEXUS header.");
+    }
+}
+
+bool NexusReader::readStatement(std::string &statement) {
+    statement.clear();
+
+    int depth = 0;
+    bool in_quotes = false;
+    char c;
+
+    while (in_.get(c)) {
+        if (in_quotes) {
+            statement += c;
+            if (c == '\'') {
+                // '' is an escaped quote: the next character reopens the quotes
+                in_quotes = false;
+            }
+        } else if (c == '[') {
+            ++depth;
+        } else if (depth > 0) {
+            if (c == ']') {
+                --depth;
+            }
+        } else if (c == '\'') {
+            statement += c;
+            in_quotes = true;
+        } else if (c == ';') {
+            return true;
+        } else {
+            statement += c;
+        }
+    }
+
+    return statement.find_first_not_of(" \t\r\n") != std::string::npos;
+}
+
+int NexusReader::addTaxon(const std::string &name) {
+    int idx = taxa_.size();
+    taxa_.push_back(name);
+    taxon_indices_.emplace(name, idx);
+    return idx;
+}
+
+std::string NexusReader::translateNewick(const std::string &newick) {
+    const std::string delimiters = "(),:;";
+
+    std::string out;
+    out.reserve(newick.size());
+
+    bool expect_leaf = false;
+    std::size_t i = 0;
+
+    auto readLabel = [&]() {
+        std::size_t end = i;
+        while (end < newick.size() && delimiters.find(newick[end]) == std::string::npos) {
+            if (newick[end] == '\'') {
+                end = newick.find('\'', end + 1);
+                if (end == std::string::npos) {
+                    throw std::runtime_error("Invalid NEXUS tree: unbalanced quotes.");
+                }
+            }
+            ++end;
+        }
+        std::vector<std::string> words = splitWords(newick.substr(i, end - i));
+        i = end;
+        return words;
+    };
+
+    while (i < newick.size()) {
+        char c = newick[i];
+        if (c == '(' || c == ',') {
+            out += c;
+            expect_leaf = true;
+            ++i;
+        } else if (c == ')') {
+            out += c;
+            ++i;
+            // Drop the internal node label
+            readLabel();
+            expect_leaf = false;
+        } else if (c == ':') {
+            std::size_t end = i + 1;
+            while (end < newick.size() && delimiters.find(newick[end]) == std::string::npos) {
+                ++end;
+            }
+            std::string length = newick.substr(i, end - i);
+            length.erase(std::remove_if(length.begin(), length.end(),
+                                        [](unsigned char ch) { return std::isspace(ch); }),
+                         length.end());
+            out += length;
+            i = end;
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            ++i;
+        } else if (c == ';') {
+            break;
+        } else {
+            std::vector<std::string> words = readLabel();
+            if (!expect_leaf || words.size() != 1) {
+                throw std::runtime_error("Invalid NEXUS tree: unexpected label.");
+            }
+
+            // TRANSLATE tokens take precedence over taxon names (which may be integers too)
+            int idx;
+            auto it = token_indices_.find(words[0]);
+            if (it != token_indices_.end()) {
+                idx = it->second;
+            } else if ((it = taxon_indices_.find(words[0])) != taxon_indices_.end()) {
+                idx = it->second;
+            } else if (has_taxa_) {
+                throw std::runtime_error("Invalid NEXUS tree: unknown taxon " + words[0] + ".");
+            } else {
+                // No taxon table: the first tree defines it
+                idx = addTaxon(words[0]);
+            }
+
+            out += std::to_string(idx);
+            expect_leaf = false;
+        }
+    }
+
+    has_taxa_ = true;
+
+    return out + ";";
+}
+
+bool NexusReader::next(NexusTree &tree) {
+    std::string statement;
+
+    while (readStatement(statement)) {
+        std::istringstream iss(statement);
+        std::string command;
+        iss >> command;
+        command = toLower(command);
+
+        if (command == "begin") {
+            iss >> block_;
+            block_ = toLower(block_);
+        } else if (command == "end" || command == "endblock") {
+            block_.clear();
+        } else if (command == "translate" && block_ == "trees") {
+            std::string body;
+            std::getline(iss, body, '\0');
+
+            // Entries are "token name" pairs separated by commas
+            std::vector<std::string> entry;
+            auto addEntry = [&]() {
+                if (entry.size() != 2) {
+                    throw std::runtime_error("Invalid NEXUS TRANSLATE block entry.");
+                }
+                if (!has_taxa_) {
+                    token_indices_[entry[0]] = addTaxon(entry[1]);
+                } else {
+                    // Taxa already defined by a TAXA block: only add the token, looking the name
+                    // up among names only (not among the tokens added so far)
+                    auto it = taxon_indices_.find(entry[1]);
+                    if (it == taxon_indices_.end()) {
+                        throw std::runtime_error("Unknown taxon in TRANSLATE block: " +
+                                                 entry[1] + ".");
+                    }
+                    token_indices_[entry[0]] = it->second;
+                }
+                entry.clear();
+            };
+
+            for (const auto &word : splitWords(body, ',')) {
+                if (!word.empty()) {
+                    entry.push_back(word);
+                } else if (!entry.empty()) {
+                    addEntry();
+                }
+            }
+            if (!entry.empty()) {
+                addEntry();
+            }
+
+            has_taxa_ = true;
+        } else if (command == "taxlabels" && !has_taxa_) {
+            std::vector<std::string> words = splitWords(statement);
+            for (std::size_t i = 1; i < words.size(); ++i) {
+                addTaxon(words[i]);
+            }
+            has_taxa_ = true;
+        } else if ((command == "tree" || command == "utree") && block_ == "trees") {
+            std::size_t eq = statement.find('=');
+            if (eq == std::string::npos) {
+                throw std::runtime_error("Invalid NEXUS tree statement: missing '='.");
+            }
+
+            std::vector<std::string> name = splitWords(statement.substr(0, eq));
+            // Skip the optional '*' marking the default tree
+            tree.name = name.empty() ? "" : name.back();
+            tree.newick = translateNewick(statement.substr(eq + 1));
+
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,58 @@
+#ifndef NEXUS_HPP
+#define NEXUS_HPP
+
+#include <istream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief A tree of a NEXUS file
+ * name: name of the tree (e.g., STATE_0)
+ * newick: Newick string where leaves are integers (indices in the taxon table), with branch
+ * lengths but without comments or internal node labels
+ */
+struct NexusTree {
+    std::string name;
+    std::string newick;
+};
+
+/**
+ * @brief Streaming reader of the TREES blocks of NEXUS files (e.g., MrBayes/BEAST posteriors)
+ *
+ * The taxon table is read once from the TRANSLATE block (or from the TAXLABELS of a TAXA block,
+ * or, failing that, from the leaves of the first tree) and shared by all trees. Comments and
+ * annotations ([&R], [&rate=...], ...) are skipped while reading.
+ */
+class NexusReader {
+   public:
+    explicit NexusReader(std::istream &in);
+
+    /**
+     * @brief Read the next tree
+     *
+     * @param tree output tree
+     * @return false if there are no trees left
+     */
+    bool next(NexusTree &tree);
+
+    /**
+     * @brief Taxon table: taxa()[i] is the name of leaf i
+     */
+    const std::vector<std::string> &taxa() const { return taxa_; }
+
+   private:
+    bool readStatement(std::string &statement);
+    int addTaxon(const std::string &name);
+    std::string translateNewick(const std::string &newick);
+
+    std::istream &in_;
+    std::string block_;
+    std::vector<std::string> taxa_;
+    // Taxon name -> leaf, and TRANSLATE token -> leaf (kept apart: names can be integers too)
+    std::unordered_map<std::string, int> taxon_indices_;
+    std::unordered_map<std::string, int> token_indices_;
+    bool has_taxa_;
+};
+
+#endif  // NEXUS_HPP
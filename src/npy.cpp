@@ -0,0 +1,370 @@
+#include "npy.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+// Data is written and mapped as little-endian ('<i2', '<i4') without byte swapping
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Big-endian hosts are not supported by npy.cpp."
+#endif
+
+const char NPY_MAGIC[] = "\x93NUMPY";
+const std::size_t NPY_MAGIC_SIZE = 6;
+// Rows are written to disk in chunks of at least this number of bytes
+const std::size_t NPY_CHUNK_SIZE = 1 << 20;
+
+std::size_t getItemsize(NpyDtype dtype) { return dtype == NpyDtype::INT16 ? 2 : 4; }
+
+namespace {
+
+/**
+ * @brief a * b, or false if it overflows
+ */
+bool multiplyChecked(std::size_t a, std::size_t b, std::size_t &result) {
+    if (b != 0 && a > std::numeric_limits<std::size_t>::max() / b) {
+        return false;
+    }
+    result = a * b;
+    return true;
+}
+
+}  // namespace
+
+NpyWriter::NpyWriter(const std::string &path, const std::vector<std::size_t> &row_shape,
+                     NpyDtype dtype, bool raw)
+    : out_(path, std::ios::binary),
+      row_shape_(row_shape),
+      row_size_(std::accumulate(row_shape.begin(), row_shape.end(), std::size_t(1),
+                                std::multiplies<std::size_t>())),
+      dtype_(dtype),
+      raw_(raw),
+      header_size_(0),
+      num_rows_(0),
+      closed_(false) {
+    if (!out_) {
+        throw std::runtime_error("Could not open " + path + " for writing.");
+    }
+
+    buffer_.reserve(NPY_CHUNK_SIZE + row_size_ * getItemsize(dtype_));
+
+    if (!raw_) {
+        // Reserve enough space for the largest possible number of rows
+        std::string header = makeHeader(static_cast<std::size_t>(-1));
+        header_size_ = header.size();
+        out_.write(header.data(), header.size());
+    }
+}
+
+NpyWriter::~NpyWriter() {
+    if (!closed_) {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+}
+
+std::string NpyWriter::makeHeader(std::size_t num_rows) const {
+    std::ostringstream dict;
+    dict << "{'descr': '" << (dtype_ == NpyDtype::INT16 ? "<i2" : "<i4")
+         << "', 'fortran_order': False, 'shape': (" << num_rows << ",";
+    for (std::size_t i = 0; i < row_shape_.size(); ++i) {
+        dict << (i > 0 ? ", " : " ") << row_shape_[i];
+    }
+    dict << "), }";
+
+    std::string header(NPY_MAGIC, NPY_MAGIC_SIZE);
+    header += '\x01';
+    header += '\x00';
+
+    // The total header size is a multiple of 64 bytes, and is fixed by the first call
+    std::size_t total_size = header_size_;
+    if (total_size == 0) {
+        total_size = (NPY_MAGIC_SIZE + 4 + dict.str().size() + 1 + 63) / 64 * 64;
+    }
+
+    const std::size_t dict_size = total_size - NPY_MAGIC_SIZE - 4;
+    header += static_cast<char>(dict_size & 0xff);
+    header += static_cast<char>(dict_size >> 8);
+
+    std::string padded_dict = dict.str();
+    padded_dict.resize(dict_size - 1, ' ');
+    header += padded_dict + '\n';
+
+    return header;
+}
+
+void NpyWriter::write(const int *row) {
+    if (closed_) {
+        throw std::logic_error("Cannot write to a closed NpyWriter.");
+    }
+
+    const std::size_t itemsize = getItemsize(dtype_);
+    const std::size_t offset = buffer_.size();
+    buffer_.resize(offset + row_size_ * itemsize);
+    char *out = buffer_.data() + offset;
+
+    for (std::size_t i = 0; i < row_size_; ++i) {
+        const std::uint32_t val = row[i];
+        if (dtype_ == NpyDtype::INT16 && (row[i] < -32768 || row[i] > 32767)) {
+            std::ostringstream oss;
+            oss << "Value " << row[i] << " does not fit in int16, use NpyDtype::INT32.";
+            buffer_.resize(offset);
+            throw std::out_of_range(oss.str());
+        }
+        for (std::size_t b = 0; b < itemsize; ++b) {
+            out[i * itemsize + b] = static_cast<char>(val >> (8 * b));
+        }
+    }
+
+    ++num_rows_;
+
+    if (buffer_.size() >= NPY_CHUNK_SIZE) {
+        flushBuffer();
+    }
+}
+
+void NpyWriter::write(const std::vector<int> &v) {
+    if (v.size() != row_size_) {
+        std::ostringstream oss;
+        oss << "Rows should have " << row_size_ << " entries, found " << v.size() << ".";
+        throw std::invalid_argument(oss.str());
+    }
+    write(v.data());
+}
+
+void NpyWriter::write(const std::vector<std::array<int, 3>> &M) {
+    if (3 * M.size() != row_size_) {
+        std::ostringstream oss;
+        oss << "Rows should have " << row_size_ << " entries, found " << 3 * M.size() << ".";
+        throw std::invalid_argument(oss.str());
+    }
+    // std::array<int, 3> has no padding: M is a contiguous block of 3 * k ints
+    write(M.empty() ? nullptr : M[0].data());
+}
+
+void NpyWriter::flushBuffer() {
+    out_.write(buffer_.data(), buffer_.size());
+    if (!out_) {
+        throw std::runtime_error("Could not write to the output file.");
+    }
+    buffer_.clear();
+}
+
+void NpyWriter::close() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+
+    flushBuffer();
+
+    if (!raw_) {
+        std::string header = makeHeader(num_rows_);
+        out_.seekp(0);
+        out_.write(header.data(), header.size());
+    }
+
+    out_.close();
+    if (!out_) {
+        throw std::runtime_error("Could not write to the output file.");
+    }
+}
+
+void writeNpy(const std::string &path, const std::vector<std::vector<int>> &vs, NpyDtype dtype) {
+    NpyWriter writer(path, {vs.empty() ? 0 : vs[0].size()}, dtype);
+    for (const auto &v : vs) {
+        writer.write(v);
+    }
+    writer.close();
+}
+
+MappedNpy::MappedNpy(const std::string &path)
+    : mapping_(nullptr), mapping_size_(0), data_(nullptr), row_size_(1) {
+    map(path);
+
+    const char *bytes = static_cast<const char *>(mapping_);
+
+    if (mapping_size_ < NPY_MAGIC_SIZE + 4 ||
+        std::memcmp(bytes, NPY_MAGIC, NPY_MAGIC_SIZE) != 0) {
+        fail(path + " is not a .npy file.");
+    }
+
+    // Version 1.0 has a 2-byte header length, versions 2.0 and 3.0 a 4-byte header length
+    const int major = bytes[NPY_MAGIC_SIZE];
+    const std::size_t len_size = major == 1 ? 2 : 4;
+    if (mapping_size_ < NPY_MAGIC_SIZE + 2 + len_size) {
+        fail(path + ": truncated .npy header.");
+    }
+    std::size_t dict_size = 0;
+    for (std::size_t b = 0; b < len_size; ++b) {
+        dict_size |= static_cast<std::size_t>(
+                         static_cast<unsigned char>(bytes[NPY_MAGIC_SIZE + 2 + b]))
+                     << (8 * b);
+    }
+
+    const std::size_t header_size = NPY_MAGIC_SIZE + 2 + len_size + dict_size;
+    if (header_size > mapping_size_) {
+        fail(path + ": truncated .npy header.");
+    }
+
+    const std::string dict(bytes + header_size - dict_size, dict_size);
+
+    if (dict.find("'<i2'") != std::string::npos) {
+        dtype_ = NpyDtype::INT16;
+    } else if (dict.find("'<i4'") != std::string::npos) {
+        dtype_ = NpyDtype::INT32;
+    } else {
+        fail(path + ": only little-endian int16 and int32 are supported.");
+    }
+
+    if (dict.find("'fortran_order': False") == std::string::npos) {
+        fail(path + ": only C-contiguous arrays are supported.");
+    }
+
+    const std::size_t shape_key = dict.find("'shape'");
+    const std::size_t shape_start =
+        shape_key == std::string::npos ? std::string::npos : dict.find('(', shape_key);
+    const std::size_t shape_end =
+        shape_start == std::string::npos ? std::string::npos : dict.find(')', shape_start);
+    if (shape_end == std::string::npos) {
+        fail(path + ": missing shape in the .npy header.");
+    }
+
+    std::string shape = dict.substr(shape_start + 1, shape_end - shape_start - 1);
+    std::replace(shape.begin(), shape.end(), ',', ' ');
+
+    std::istringstream iss(shape);
+    std::size_t dim;
+    while (iss >> dim) {
+        shape_.push_back(dim);
+    }
+    if (!iss.eof()) {
+        fail(path + ": invalid shape in the .npy header.");
+    }
+
+    if (shape_.empty()) {
+        fail(path + ": scalar arrays are not supported.");
+    }
+
+    // Sizes come from the file: check for overflows before comparing with the file size
+    std::size_t data_size = getItemsize(dtype_);
+    row_size_ = 1;
+    for (std::size_t i = 0; i < shape_.size(); ++i) {
+        if ((i > 0 && !multiplyChecked(row_size_, shape_[i], row_size_)) ||
+            !multiplyChecked(data_size, shape_[i], data_size)) {
+            fail(path + ": .npy shape too large.");
+        }
+    }
+
+    data_ = bytes + header_size;
+
+    if (data_size > mapping_size_ - header_size) {
+        fail(path + ": truncated .npy data.");
+    }
+}
+
+MappedNpy::MappedNpy(const std::string &path, const std::vector<std::size_t> &row_shape,
+                     NpyDtype dtype)
+    : mapping_(nullptr),
+      mapping_size_(0),
+      data_(nullptr),
+      row_size_(std::accumulate(row_shape.begin(), row_shape.end(), std::size_t(1),
+                                std::multiplies<std::size_t>())),
+      dtype_(dtype) {
+    map(path);
+
+    data_ = static_cast<const char *>(mapping_);
+
+    const std::size_t row_bytes = row_size_ * getItemsize(dtype_);
+    if (row_bytes == 0 || mapping_size_ % row_bytes != 0) {
+        fail(path + ": the file size is not a multiple of the row size.");
+    }
+
+    shape_.push_back(mapping_size_ / row_bytes);
+    shape_.insert(shape_.end(), row_shape.begin(), row_shape.end());
+}
+
+MappedNpy::~MappedNpy() {
+    if (mapping_ != nullptr) {
+        munmap(mapping_, mapping_size_);
+        mapping_ = nullptr;
+    }
+}
+
+void MappedNpy::map(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::runtime_error("Could not open " + path + ".");
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        ::close(fd);
+        throw std::runtime_error("Could not stat " + path + ".");
+    }
+
+    mapping_size_ = st.st_size;
+
+    if (mapping_size_ > 0) {
+        mapping_ = mmap(nullptr, mapping_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping_ == MAP_FAILED) {
+            mapping_ = nullptr;
+            ::close(fd);
+            throw std::runtime_error("Could not map " + path + ".");
+        }
+    }
+
+    ::close(fd);
+}
+
+void MappedNpy::fail(const std::string &message) {
+    // The destructor is not called when a constructor throws
+    if (mapping_ != nullptr) {
+        munmap(mapping_, mapping_size_);
+        mapping_ = nullptr;
+    }
+    throw std::runtime_error(message);
+}
+
+void MappedNpy::checkType(std::size_t itemsize) const {
+    if (itemsize != getItemsize(dtype_)) {
+        throw std::invalid_argument("The requested type does not match the array dtype.");
+    }
+}
+
+std::vector<int> MappedNpy::getRow(std::size_t i) const {
+    if (i >= num_rows()) {
+        std::ostringstream oss;
+        oss << "Row " << i << " out of range for an array of " << num_rows() << " rows.";
+        throw std::out_of_range(oss.str());
+    }
+
+    const unsigned char *row = reinterpret_cast<const unsigned char *>(data_) +
+                               i * row_size_ * getItemsize(dtype_);
+
+    std::vector<int> values(row_size_);
+    for (std::size_t j = 0; j < row_size_; ++j) {
+        if (dtype_ == NpyDtype::INT16) {
+            values[j] = static_cast<std::int16_t>(row[2 * j] | (row[2 * j + 1] << 8));
+        } else {
+            std::uint32_t val = 0;
+            for (int b = 0; b < 4; ++b) {
+                val |= static_cast<std::uint32_t>(row[4 * j + b]) << (8 * b);
+            }
+            values[j] = static_cast<std::int32_t>(val);
+        }
+    }
+
+    return values;
+}
@@ -0,0 +1,145 @@
+#ifndef NPY_HPP
+#define NPY_HPP
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * Export of batches of vectors (or ancestry matrices) to NumPy .npy files or raw binary files
+ *
+ * Arrays are C-contiguous (row-major) and little-endian. Rows are streamed to disk in chunks, so
+ * that the number of rows does not need to be known in advance: the .npy header reserves enough
+ * space for any number of rows and is completed when the writer is closed.
+ */
+
+/**
+ * @brief Supported data types
+ * INT16 is enough for trees with up to 16384 leaves (0 <= v[i] <= 2i)
+ */
+enum class NpyDtype { INT16, INT32 };
+
+/**
+ * @brief Streaming writer of a 2D (vectors) or 3D (ancestry matrices) integer array
+ */
+class NpyWriter {
+   public:
+    /**
+     * @param path output file
+     * @param row_shape shape of each row, e.g. {k} for vectors or {k, 3} for ancestry matrices
+     * @param dtype data type of the output array
+     * @param raw if true, write the data only (no .npy header)
+     */
+    NpyWriter(const std::string &path, const std::vector<std::size_t> &row_shape,
+              NpyDtype dtype = NpyDtype::INT32, bool raw = false);
+    ~NpyWriter();
+
+    /**
+     * @brief Append a row of row_size() integers
+     */
+    void write(const int *row);
+
+    /**
+     * @brief Append a vector (row_shape should be {v.size()})
+     */
+    void write(const std::vector<int> &v);
+
+    /**
+     * @brief Append an ancestry matrix (row_shape should be {M.size(), 3})
+     */
+    void write(const std::vector<std::array<int, 3>> &M);
+
+    /**
+     * @brief Flush the remaining rows and complete the header
+     */
+    void close();
+
+    std::size_t row_size() const { return row_size_; }
+    std::size_t num_rows() const { return num_rows_; }
+
+   private:
+    void flushBuffer();
+    std::string makeHeader(std::size_t num_rows) const;
+
+    std::ofstream out_;
+    std::vector<std::size_t> row_shape_;
+    std::size_t row_size_;
+    NpyDtype dtype_;
+    bool raw_;
+    std::size_t header_size_;
+    std::size_t num_rows_;
+    std::vector<char> buffer_;
+    bool closed_;
+};
+
+/**
+ * @brief Write a batch of equal-length vectors to a .npy file
+ *
+ * @param path output file
+ * @param vs Phylo2Vec vectors, all of the same size
+ * @param dtype data type of the output array
+ */
+void writeNpy(const std::string &path, const std::vector<std::vector<int>> &vs,
+              NpyDtype dtype = NpyDtype::INT32);
+
+/**
+ * @brief Read-only memory mapping of a .npy file (or of a raw file written by NpyWriter)
+ * Rows can be accessed without copying with data<T>() + i * row_size().
+ */
+class MappedNpy {
+   public:
+    /**
+     * @brief Map a .npy file: shape and dtype are read from its header
+     */
+    explicit MappedNpy(const std::string &path);
+
+    /**
+     * @brief Map a raw file
+     *
+     * @param path input file
+     * @param row_shape shape of each row
+     * @param dtype data type of the array
+     */
+    MappedNpy(const std::string &path, const std::vector<std::size_t> &row_shape, NpyDtype dtype);
+
+    ~MappedNpy();
+    MappedNpy(const MappedNpy &) = delete;
+    MappedNpy &operator=(const MappedNpy &) = delete;
+
+    const std::vector<std::size_t> &shape() const { return shape_; }
+    NpyDtype dtype() const { return dtype_; }
+    std::size_t num_rows() const { return shape_[0]; }
+    std::size_t row_size() const { return row_size_; }
+
+    /**
+     * @brief Pointer to the first element (T must match the dtype)
+     * Elements are read in host byte order: only little-endian hosts are supported (npy.cpp does
+     * not build on big-endian hosts).
+     */
+    template <typename T>
+    const T *data() const {
+        checkType(sizeof(T));
+        return reinterpret_cast<const T *>(data_);
+    }
+
+    /**
+     * @brief Copy row i into a vector
+     */
+    std::vector<int> getRow(std::size_t i) const;
+
+   private:
+    void map(const std::string &path);
+    [[noreturn]] void fail(const std::string &message);
+    void checkType(std::size_t itemsize) const;
+
+    void *mapping_;
+    std::size_t mapping_size_;
+    const char *data_;
+    std::vector<std::size_t> shape_;
+    std::size_t row_size_;
+    NpyDtype dtype_;
+};
+
+#endif  // NPY_HPP
@@ -3,7 +3,10 @@
 // #include <omp.h>
 
 #include <algorithm>
+#include <cctype>
 #include <iostream>
+#include <numeric>
+#include <queue>
 #include <random>
 #include <regex>
 #include <sstream>
@@ -76,146 +79,386 @@ std::vector<std::vector<int>> initViewMatrix(const int &k) {
 }
 
 std::vector<std::array<int, 3>> getAncestry(const std::vector<int> &v) {
-    const std::size_t k = v.size();
-
-    // init "view" matrix
-    std::vector<std::vector<int>> labels = initViewMatrix(k);
+    return getAncestryFromPairs(getPairs(v));
+}
 
-    std::vector<int> labels_last_row(k + 1);
-    std::iota(labels_last_row.begin(), labels_last_row.end(), 0);
+void addPair(std::vector<std::pair<int, int>> &pairs, int j, int v_j) {
+    if (v_j < 0 || v_j > 2 * j || pairs.size() != static_cast<std::size_t>(j)) {
+        std::ostringstream oss;
+        oss << "Invalid value at index " << j << ": v[j] should be in [0, 2j] and follow " << j
+            << " pairs, found v[j] = " << v_j << " and " << pairs.size() << " pairs.";
+        throw std::out_of_range(oss.str());
+    }
 
-    std::vector<bool> not_processed(k, true);
-    std::vector<std::array<int, 3>> M(k, {{0, 0, 0}});
+    const int next_leaf = j + 1;
 
-    for (std::size_t step = 0; step < k; ++step) {
-        std::vector<int> row_maxes(k);
+    if (v_j <= j) {
+        // The next leaf forms a cherry with leaf v[j], merged before all previous pairs
+        pairs.insert(pairs.begin(), std::make_pair(v_j, next_leaf));
+    } else if (v_j == 2 * j) {
+        // The next leaf is attached above the root
+        pairs.push_back(std::make_pair(0, next_leaf));
+    } else {
+        // The next leaf is attached above the node created by pairs[index - 1]
+        const int index = pairs.size() + v_j - 2 * j;
+        pairs.insert(pairs.begin() + index, std::make_pair(pairs[index - 1].first, next_leaf));
+    }
+}
 
-        int n = -1;
+std::vector<std::pair<int, int>> getPairs(const std::vector<int> &v) {
+    // The Fenwick tree passes below index out of bounds for invalid values
+    check_v(v);
 
-        for (int row = 0; row < k; ++row) {
-            int row_max = 0;
-            for (std::size_t col = 0; col <= row; ++col) {
-                row_max = std::max(row_max, labels[row][col]);
-            }
-            row_maxes[row] = row_max;
+    const int k = v.size();
 
-            if (v[row] <= row_max && not_processed[row]) {
-                n = row;
+    // Fenwick trees over the final positions of the pairs
+    std::vector<int> fenwick(k + 1, 0);
+    auto add = [&fenwick, k](int pos, int delta) {
+        for (int i = pos + 1; i <= k; i += i & -i) {
+            fenwick[i] += delta;
+        }
+    };
+    // Position of the (n + 1)-th occupied slot
+    int log_k = 1;
+    while ((1 << log_k) <= k) {
+        ++log_k;
+    }
+    auto findNth = [&fenwick, k, log_k](int n) {
+        int pos = 0;
+        for (int step = 1 << log_k; step > 0; step >>= 1) {
+            if (pos + step <= k && fenwick[pos + step] <= n) {
+                pos += step;
+                n -= fenwick[pos];
             }
         }
-
-        if (n == -1) {
-            throw std::out_of_range("n should be a positive index.");
+        return pos;
+    };
+
+    // Index at which addPair inserts each pair in the list of j pairs
+    std::vector<int> indices(k);
+    for (int j = 0; j < k; ++j) {
+        if (v[j] <= j) {
+            indices[j] = 0;
+        } else if (v[j] == 2 * j) {
+            indices[j] = j;
+        } else {
+            indices[j] = v[j] - j;
         }
+    }
 
-        // find m
-        int m = -1;
-        for (int i = 0; i < k; ++i) {
-            if (labels[n][i] == v[n]) {
-                m = i;
-                break;
-            }
-        }
+    // 1st pass (offline list insertion): pair j ends up in the indices[j]-th slot that is not
+    // taken by a later pair
+    std::vector<int> positions(k);
+    for (int pos = 0; pos < k; ++pos) {
+        add(pos, 1);
+    }
+    for (int j = k - 1; j >= 0; --j) {
+        positions[j] = findNth(indices[j]);
+        add(positions[j], -1);
+    }
 
-        if (m == -1) {
-            throw std::out_of_range("m should be a positive index.");
+    // 2nd pass: pair j is attached above the pair at index indices[j] - 1 among pairs 0..j-1,
+    // i.e., the (indices[j] - 1)-th occupied slot
+    std::vector<std::pair<int, int>> pairs(k);
+    for (int j = 0; j < k; ++j) {
+        std::pair<int, int> pair;
+        if (v[j] <= j) {
+            pair = std::make_pair(v[j], j + 1);
+        } else if (v[j] == 2 * j) {
+            pair = std::make_pair(0, j + 1);
+        } else {
+            pair = std::make_pair(pairs[findNth(indices[j] - 1)].first, j + 1);
         }
 
-        // Update the ancestry matrix
-        M[step][0] = labels_last_row[m];
-        M[step][1] = labels_last_row[n + 1];
+        pairs[positions[j]] = pair;
+        add(positions[j], 1);
+    }
 
-        // Update the view matrix
-        for (std::size_t row = n; row < k; ++row) {
-            labels[row][m] = row_maxes[row] + 1;
+    return pairs;
+}
+
+std::vector<std::array<int, 3>> getAncestryFromPairs(
+    const std::vector<std::pair<int, int>> &pairs) {
+    const int k = pairs.size();
+
+    // Current top of the subtree containing each leaf
+    std::vector<int> parents(2 * k + 1, -1);
+    auto getTop = [&parents](int node) {
+        int top = node;
+        while (parents[top] != -1) {
+            top = parents[top];
         }
+        // Path compression
+        while (parents[node] != -1 && parents[node] != top) {
+            int next = parents[node];
+            parents[node] = top;
+            node = next;
+        }
+        return top;
+    };
+
+    std::vector<std::array<int, 3>> M(k);
+    for (int step = 0; step < k; ++step) {
+        const int child1 = getTop(pairs[step].first);
+        const int child2 = getTop(pairs[step].second);
+        const int parent = k + 1 + step;
 
-        labels_last_row[m] = *std::max_element(labels_last_row.begin(), labels_last_row.end()) + 1;
+        // Rows are stored from the root (cf. getAncestry)
+        M[k - 1 - step] = {{parent, child2, child1}};
 
-        M[step][2] = labels_last_row[m];
-        not_processed[n] = false;
+        parents[child1] = parent;
+        parents[child2] = parent;
     }
 
-    // flip rows and columns so that we get:
-    // 1st column: parent
-    // 2nd and 3rd columns: children
-    flip(M);
     return M;
 }
 
 std::string buildNewick(std::vector<std::array<int, 3>> M) {
-    std::vector<std::string> parent_nodes;
+    const int k = M.size();
+    if (k == 0) {
+        return "0;";
+    }
 
-    std::vector<std::string> sub_newicks;
+    std::vector<std::array<int, 2>> children(2 * k + 1, {{-1, -1}});
+    for (const auto &row : M) {
+        children[row[0]] = {{row[1], row[2]}};
+    }
 
-    int k = M.size();
+    std::string newick;
+    newick.reserve(8 * k);
+
+    // Iterative depth-first traversal writing (child1,child2)parent
+    // Negative entries of the stack close internal nodes (~node) or separate children (comma)
+    const int comma = -(2 * k + 2);
+    std::vector<int> stack = {M[0][0]};
+    while (!stack.empty()) {
+        const int node = stack.back();
+        stack.pop_back();
+
+        if (node == comma) {
+            newick += ',';
+        } else if (node < 0) {
+            newick += ')';
+            newick += std::to_string(~node);
+        } else if (children[node][0] == -1) {
+            newick += std::to_string(node);
+        } else {
+            int first = children[node][0], second = children[node][1];
+            // A subtree is written before a leaf sibling
+            if (children[first][0] == -1 && children[second][0] != -1) {
+                std::swap(first, second);
+            }
+            newick += '(';
+            stack.push_back(~node);
+            stack.push_back(second);
+            stack.push_back(comma);
+            stack.push_back(first);
+        }
+    }
 
-    for (int i = k - 1; i >= 0; --i) {
-        std::string parent = std::to_string(M[i][0]);
-        std::string child1 = std::to_string(M[i][1]);
-        std::string child2 = std::to_string(M[i][2]);
+    return newick + ";";
+}
 
-        auto it1 = std::find(parent_nodes.begin(), parent_nodes.end(), child1);
-        auto it2 = std::find(parent_nodes.begin(), parent_nodes.end(), child2);
+std::string toNewick(const std::vector<int> &v) { return buildNewick(getAncestry(v)); }
 
-        int idx1 = it1 != parent_nodes.end() ? std::distance(parent_nodes.begin(), it1) : -1;
-        int idx2 = it2 != parent_nodes.end() ? std::distance(parent_nodes.begin(), it2) : -1;
+std::vector<int> fromAncestry(const std::vector<std::array<int, 3>> &M) {
+    const int k = M.size();
+    const int num_nodes = 2 * k + 1;
 
-        if (idx1 >= 0 && idx2 >= 0) {
-            // Case 1: Both children are parent nodes, so we have sub-newicks for them
+    std::vector<int> parents(num_nodes, -1);
+    std::vector<std::array<int, 2>> children(num_nodes, {{-1, -1}});
 
-            // Merge the sub-newicks and add the parent node
-            sub_newicks[idx1] = "(" + sub_newicks[idx1] + "," + sub_newicks[idx2] + ")" + parent;
+    for (const auto &row : M) {
+        for (int node : row) {
+            if (node < 0 || node >= num_nodes) {
+                std::ostringstream oss;
+                oss << "Invalid node label " << node << " in an ancestry with " << k + 1
+                    << " leaves.";
+                throw std::invalid_argument(oss.str());
+            }
+        }
+        if (row[0] <= k) {
+            throw std::invalid_argument("Leaves (0..k) cannot be parent nodes.");
+        }
+        children[row[0]] = {{row[1], row[2]}};
+        parents[row[1]] = row[0];
+        parents[row[2]] = row[0];
+    }
 
-            // Update the parent node for the 1st children
-            parent_nodes[idx1] = parent;
+    // 1st pass: remove leaves from k down to 1
+    // When leaf b is removed, its sister subtree is where b was attached in the tree of leaves
+    // 0..b-1, and its parent is the internal node created when b was added
+    std::vector<int> sisters(k + 1, -1);
+    std::vector<int> rows(num_nodes, -1);
 
-            // Discard info on 2nd children as merged with the 1st children
-            sub_newicks.erase(sub_newicks.begin() + idx2);
+    for (int b = k; b >= 1; --b) {
+        int parent = parents[b];
+        if (parent == -1) {
+            throw std::invalid_argument("Each leaf should have a parent node.");
+        }
+        int sister = children[parent][0] == b ? children[parent][1] : children[parent][0];
 
-            parent_nodes.erase(parent_nodes.begin() + idx2);
-        } else if (idx1 >= 0) {
-            // Case 2: only the first child is a parent node
+        sisters[b] = sister;
+        rows[parent] = b - 1;
 
-            // Update its sub-Newick:
-            // (sub_child1.1, sub_child1.2)child_1 -->
-            // ((sub_child1.1,sub_child1.2)child_1,child_2)parent
-            sub_newicks[idx1].insert(sub_newicks[idx1].find(child1) + child1.size(),
-                                     "," + child2 + ")" + parent);
+        int grandparent = parents[parent];
+        parents[sister] = grandparent;
+        if (grandparent != -1) {
+            auto &siblings = children[grandparent];
+            siblings[siblings[0] == parent ? 0 : 1] = sister;
+        }
+    }
 
-            sub_newicks[idx1].insert(0, "(");
+    // getAncestry processes the largest row whose target node already exists.
+    // Row n depends on the row that created its sister (if the sister is not a leaf)
+    std::vector<std::vector<int>> dependents(k);
+    std::priority_queue<int> available;
+    for (int b = 1; b <= k; ++b) {
+        if (sisters[b] <= k) {
+            available.push(b - 1);
+        } else {
+            dependents[rows[sisters[b]]].push_back(b - 1);
+        }
+    }
 
-            // Update the parent node (child 1 is now just an internal node)
-            parent_nodes[idx1] = parent;
-        } else if (idx2 >= 0) {
-            // Case 3: only the second child is a parent node (similar to Case 2)
+    std::vector<int> order(k, -1);
+    for (int step = 0; step < k; ++step) {
+        if (available.empty()) {
+            throw std::invalid_argument("Invalid ancestry: the tree is not binary and rooted.");
+        }
+        int row = available.top();
+        available.pop();
+        order[row] = step;
+        for (int dependent : dependents[row]) {
+            available.push(dependent);
+        }
+    }
 
-            // (sub_child2.1, sub_child2.2)child_2 -->
-            // ((sub_child2.1,sub_child2.2)child_2, child_1)parent
-            sub_newicks[idx2].insert(sub_newicks[idx2].find(child2) + child2.size(),
-                                     "," + child1 + ")" + parent);
+    // 2nd pass: label each sister node in the tree of leaves 0..b-1
+    // Internal labels start at b and follow the processing order of the remaining rows,
+    // which is tracked with a Fenwick tree over the processing order
+    std::vector<int> fenwick(k + 1, 0);
+    for (int i = 1; i <= k; ++i) {
+        fenwick[i]++;
+        int j = i + (i & -i);
+        if (j <= k) {
+            fenwick[j] += fenwick[i];
+        }
+    }
 
-            sub_newicks[idx2].insert(0, "(");
+    std::vector<int> v(k, 0);
+    for (int b = k; b >= 1; --b) {
+        for (int i = order[b - 1] + 1; i <= k; i += i & -i) {
+            fenwick[i]--;
+        }
 
-            // Update the parent node (child 2 is now just an internal node)
-            parent_nodes[idx2] = parent;
+        int sister = sisters[b];
+        if (sister <= k) {
+            v[b - 1] = sister;
         } else {
-            // Case 4: the children nodes have not been added yet
+            int num_before = 0;
+            for (int i = order[rows[sister]]; i > 0; i -= i & -i) {
+                num_before += fenwick[i];
+            }
+            v[b - 1] = b + num_before;
+        }
+    }
 
-            // Add a new sub-Newick for this triplet
-            sub_newicks.push_back("(" + child1 + "," + child2 + ")" + parent);
+    return v;
+}
+
+std::vector<int> getInducedSubtree(const std::vector<int> &v, const std::vector<int> &new_labels,
+                                   int num_kept) {
+    const std::size_t k = v.size();
+
+    std::vector<std::array<int, 3>> M = getAncestry(v);
+
+    // Node representing each subtree in the induced tree (-1 if no kept leaf below)
+    std::vector<int> reps(2 * k + 1, -1);
+    std::copy(new_labels.begin(), new_labels.end(), reps.begin());
+
+    std::vector<std::array<int, 3>> induced_M;
+    induced_M.reserve(num_kept - 1);
+
+    int next_parent = num_kept;
+
+    // Rows of M are stored from the root: iterate backwards to visit children first
+    for (auto it = M.rbegin(); it != M.rend(); ++it) {
+        int rep1 = reps[(*it)[1]];
+        int rep2 = reps[(*it)[2]];
 
-            parent_nodes.push_back(parent);
+        if (rep1 >= 0 && rep2 >= 0) {
+            induced_M.push_back({{next_parent, rep1, rep2}});
+            reps[(*it)[0]] = next_parent++;
+        } else {
+            reps[(*it)[0]] = rep1 >= 0 ? rep1 : rep2;
         }
     }
-    // If everything went well, only one "sub-newick" should be left, with only
-    // one parent: the root node
 
-    std::string newick = sub_newicks[0] + ";";
-    return newick;
+    return fromAncestry(induced_M);
 }
 
-std::string toNewick(const std::vector<int> &v) { return buildNewick(getAncestry(v)); }
+std::vector<int> relabelLeaves(const std::vector<bool> &keep, std::size_t num_leaves) {
+    if (keep.size() != num_leaves) {
+        std::ostringstream oss;
+        oss << "The leaf mask should have " << num_leaves << " entries, found " << keep.size()
+            << ".";
+        throw std::invalid_argument(oss.str());
+    }
+
+    std::vector<int> new_labels(keep.size(), -1);
+
+    int num_kept = 0;
+    for (std::size_t i = 0; i < keep.size(); ++i) {
+        if (keep[i]) {
+            new_labels[i] = num_kept++;
+        }
+    }
+
+    if (num_kept < 2) {
+        std::ostringstream oss;
+        oss << "At least 2 leaves should be kept to get an induced subtree, found " << num_kept
+            << ".";
+        throw std::invalid_argument(oss.str());
+    }
+
+    return new_labels;
+}
+
+std::vector<int> getInducedSubtree(const std::vector<int> &v, const std::vector<bool> &keep) {
+    check_v(v);
+
+    std::vector<int> new_labels = relabelLeaves(keep, v.size() + 1);
+    int num_kept = *std::max_element(new_labels.begin(), new_labels.end()) + 1;
+
+    return getInducedSubtree(v, new_labels, num_kept);
+}
+
+std::vector<std::vector<int>> getInducedSubtrees(const std::vector<std::vector<int>> &vs,
+                                                 const std::vector<bool> &keep) {
+    std::vector<int> new_labels = relabelLeaves(keep, keep.size());
+
+    // Validate everything first: exceptions cannot leave a parallel region
+    for (const auto &v : vs) {
+        check_v(v);
+        if (v.size() + 1 != keep.size()) {
+            std::ostringstream oss;
+            oss << "All vectors should have " << keep.size() - 1 << " entries, found "
+                << v.size() << ".";
+            throw std::invalid_argument(oss.str());
+        }
+    }
+    int num_kept = *std::max_element(new_labels.begin(), new_labels.end()) + 1;
+
+    std::vector<std::vector<int>> induced_vs(vs.size());
+
+#pragma omp parallel for schedule(dynamic)
+    for (std::size_t i = 0; i < vs.size(); ++i) {
+        induced_vs[i] = getInducedSubtree(vs[i], new_labels, num_kept);
+    }
+
+    return induced_vs;
+}
 
 void removeBranchLengthAnnotations(std::string &newick) {
     std::regex pattern(":\\d+(\\.\\d+)?");
@@ -389,44 +632,146 @@ void updateNewick(std::string &newick, int left_leaf_ind, int left_leaf, int rig
     }
 }
 
-std::vector<int> toVector(std::string newick, int num_leaves) {
-    std::vector<int> v(num_leaves, 0);
-    std::vector<bool> processed(num_leaves, false);
-    std::vector<int> vmin(num_leaves, 0);
+std::vector<std::array<int, 3>> getAncestryFromNewick(const std::string &newick,
+                                                      std::vector<double> &branch_lengths) {
+    // Nodes are first given temporary ids: leaves keep their label, internal nodes get
+    // -1, -2, ... in the order they are closed
+    std::vector<std::array<int, 3>> M;
+    std::vector<std::pair<int, double>> lengths;
+
+    std::vector<std::vector<int>> open_nodes;
+    int last_node = 0;
+    bool has_last_node = false;
+
+    std::size_t i = 0;
+    const std::size_t n = newick.size();
+    while (i < n && newick[i] != ';') {
+        char c = newick[i];
+        if (c == '(') {
+            open_nodes.emplace_back();
+            has_last_node = false;
+            ++i;
+        } else if (c == ',' || c == ')') {
+            if (open_nodes.empty() || !has_last_node) {
+                throw std::invalid_argument("Invalid Newick string: unbalanced parentheses.");
+            }
+            open_nodes.back().push_back(last_node);
+            has_last_node = false;
+            ++i;
+
+            if (c == ')') {
+                if (open_nodes.back().size() != 2) {
+                    throw std::invalid_argument(
+                        "Invalid Newick string: the tree should be rooted and binary.");
+                }
+                last_node = -static_cast<int>(M.size()) - 1;
+                M.push_back({{last_node, open_nodes.back()[0], open_nodes.back()[1]}});
+                open_nodes.pop_back();
+                has_last_node = true;
+
+                // Skip the parent annotation
+                while (i < n && std::string(",():;").find(newick[i]) == std::string::npos) {
+                    ++i;
+                }
+            }
+        } else if (c == ':') {
+            if (!has_last_node) {
+                throw std::invalid_argument("Invalid Newick string: misplaced branch length.");
+            }
+            std::size_t end = ++i;
+            while (end < n && std::string(",();").find(newick[end]) == std::string::npos) {
+                ++end;
+            }
+            lengths.emplace_back(last_node, std::stod(newick.substr(i, end - i)));
+            i = end;
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            ++i;
+        } else {
+            std::size_t end = i;
+            while (end < n && std::isdigit(static_cast<unsigned char>(newick[end]))) {
+                ++end;
+            }
+            if (end == i) {
+                std::ostringstream oss;
+                oss << "Invalid Newick string: unexpected character '" << c << "' at position "
+                    << i << ". Are the Newick nodes integers (and not taxa)?";
+                throw std::invalid_argument(oss.str());
+            }
+            last_node = std::stoi(newick.substr(i, end - i));
+            has_last_node = true;
+            i = end;
+        }
+    }
 
-    std::vector<int> labels(num_leaves);
-    std::iota(labels.begin(), labels.end(), 0);
+    if (!open_nodes.empty()) {
+        throw std::invalid_argument("Invalid Newick string: unbalanced parentheses.");
+    }
 
-    try {
-        for (int i = 0; i < num_leaves - 1; ++i) {
-            std::pair<int, int> tmp = findLeftLeaf(newick, labels, processed, num_leaves);
-            int left_leaf = tmp.first;
-            int idx = tmp.second;
+    if (!has_last_node || (M.empty() && last_node != 0)) {
+        throw std::invalid_argument("Invalid Newick string: no root node found.");
+    }
 
-            int left_leaf_ind =
-                std::distance(labels.begin(), std::find(labels.begin(), labels.end(), left_leaf));
+    // Relabel internal nodes to k+1..2k
+    const int k = M.size();
+    std::vector<bool> seen(k + 1, false);
+    for (auto &row : M) {
+        for (int &node : row) {
+            if (node < 0) {
+                node = k - node;
+            } else if (node > k || seen[node]) {
+                std::ostringstream oss;
+                oss << "Invalid Newick string: leaves should be labelled 0.." << k
+                    << " exactly once, found " << node << ".";
+                throw std::invalid_argument(oss.str());
+            } else {
+                seen[node] = true;
+            }
+        }
+    }
 
-            int right_leaf = num_leaves - idx - 1;
+    branch_lengths.assign(2 * k + 1, 0.0);
+    for (const auto &length : lengths) {
+        branch_lengths[length.first < 0 ? k - length.first : length.first] = length.second;
+    }
 
-            updateVmin(vmin, right_leaf, num_leaves, processed);
+    // Put the root first (cf. getAncestry)
+    std::reverse(M.begin(), M.end());
 
-            labels[left_leaf_ind] = *std::max_element(labels.begin(), labels.end()) + 1;
+    return M;
+}
 
-            v[right_leaf] = vmin[right_leaf] == 0 ? left_leaf_ind : vmin[right_leaf];
+std::vector<int> fromNewick(const std::string &newick, RerootMethod reroot_method, int outgroup) {
+    std::vector<double> branch_lengths;
+    if (reroot_method != RerootMethod::NONE) {
+        return fromAncestry(
+            reroot(parseUnrootedNewick(newick), reroot_method, outgroup, branch_lengths));
+    }
+    return fromAncestry(getAncestryFromNewick(newick, branch_lengths));
+}
 
-            // Update the processed vector
-            processed[right_leaf] = true;
+std::vector<int> toVector(std::string newick, int num_leaves) {
+    std::vector<int> v;
 
-            updateNewick(newick, left_leaf_ind, left_leaf, right_leaf, labels);
-        }
-    } catch (const std::out_of_range &e) {
+    try {
+        std::vector<double> branch_lengths;
+        v = fromAncestry(getAncestryFromNewick(newick, branch_lengths));
+    } catch (const std::invalid_argument &e) {
         throw std::out_of_range(
-            "Have you tried reroot=True? "
+            "Is the tree unrooted? Try rerooting it (reroot_method of newick2v, --reroot). "
             "Are the Newick nodes integers (and not taxa)? "
             "If the error still persists, your tree might be "
             "unrooted or non-binary.");
     }
 
+    if (static_cast<int>(v.size()) + 1 != num_leaves) {
+        std::ostringstream oss;
+        oss << "Expected a tree with " << num_leaves << " leaves, got " << v.size() + 1 << ".";
+        throw std::out_of_range(oss.str());
+    }
+
+    // Leading 0 (v of size num_leaves)
+    v.insert(v.begin(), 0);
+
     return v;
 }
 
@@ -435,7 +780,44 @@ void processNewick(std::string &newick) {
     removeParentAnnotations(newick);
 }
 
-Newick2VResult newick2v(std::string &newick, int num_leaves) {
+/**
+ * @brief v (with a leading 0, like toVector) of a tree rooted with reroot
+ */
+std::vector<int> toRerootedVector(const UnrootedTree &tree, RerootMethod reroot_method,
+                                  int outgroup, int num_leaves) {
+    if (num_leaves != -1 && num_leaves != tree.num_leaves) {
+        std::ostringstream oss;
+        oss << "Expected a tree with " << num_leaves << " leaves, got " << tree.num_leaves << ".";
+        throw std::out_of_range(oss.str());
+    }
+
+    std::vector<double> branch_lengths;
+    std::vector<int> v = fromAncestry(reroot(tree, reroot_method, outgroup, branch_lengths));
+    v.insert(v.begin(), 0);
+
+    return v;
+}
+
+Newick2VResult newick2v(std::string &newick, int num_leaves, RerootMethod reroot_method,
+                        const std::string &outgroup) {
+    if (reroot_method != RerootMethod::NONE) {
+        UnrootedTree tree = parseUnrootedNewick(newick);
+
+        int outgroup_leaf = -1;
+        if (reroot_method == RerootMethod::LEAF) {
+            if (outgroup.empty() ||
+                outgroup.find_first_not_of("0123456789") != std::string::npos) {
+                throw std::invalid_argument("Invalid outgroup '" + outgroup +
+                                            "': expected a leaf label (integer).");
+            }
+            outgroup_leaf = std::stoi(outgroup);
+        }
+
+        Newick2VResult res = {toRerootedVector(tree, reroot_method, outgroup_leaf, num_leaves),
+                              tree.num_leaves};
+        return res;
+    }
+
     processNewick(newick);
 
     if (num_leaves == -1) {
@@ -449,7 +831,30 @@ Newick2VResult newick2v(std::string &newick, int num_leaves) {
     return res;
 }
 
-Newick2VResult newick2vWithMapping(std::string &newick, int num_leaves) {
+Newick2VResult newick2vWithMapping(std::string &newick, int num_leaves,
+                                   RerootMethod reroot_method, const std::string &outgroup) {
+    if (reroot_method != RerootMethod::NONE) {
+        std::vector<std::string> taxa;
+        UnrootedTree tree = parseUnrootedNewick(newick, &taxa);
+
+        int outgroup_leaf = -1;
+        if (reroot_method == RerootMethod::LEAF) {
+            outgroup_leaf = std::find(taxa.begin(), taxa.end(), outgroup) - taxa.begin();
+            if (outgroup_leaf == static_cast<int>(taxa.size())) {
+                throw std::invalid_argument("Unknown outgroup taxon: '" + outgroup + "'.");
+            }
+        }
+
+        std::map<std::string, std::string> mapping;
+        for (std::size_t i = 0; i < taxa.size(); ++i) {
+            mapping[std::to_string(i)] = taxa[i];
+        }
+
+        Newick2VResult res = {toRerootedVector(tree, reroot_method, outgroup_leaf, num_leaves),
+                              tree.num_leaves, mapping};
+        return res;
+    }
+
     // Newick2VResult res;
     processNewick(newick);
 
@@ -7,6 +7,8 @@
 #include <utility>
 #include <vector>
 
+#include "reroot.hpp"
+
 /**
  * @brief Result of a Newick2V operation
  * v: the output Phylo2Vec vector
@@ -64,6 +66,7 @@ void flip(T &vec, int axis = -1);
 /**
  * @brief initialise the view matrix for getAncestry
  * In Python: np.tril([np.arange(k+1)]*(k+1))
+ * @deprecated O(k^2) memory, no longer used by getAncestry (cf. getPairs)
  *
  * @param k number of leaves - 1
  * @return std::vector<std::vector<int>> matrix of size k, k+1
@@ -75,18 +78,50 @@ void flip(T &vec, int axis = -1);
  * 0 1 2 3 0 ...
  * 0 1 2 3 4 ...
  */
-std::vector<std::vector<int>> initViewMatrix(const int &k);
+[[deprecated("no longer used by getAncestry")]] std::vector<std::vector<int>> initViewMatrix(
+    const int &k);
 
 /**
  * @brief Get ancestry for each node given a v-representation.
+ * Computed in O(k log k) from the pairs of v (cf. getPairs, getAncestryFromPairs).
  *
- * @param v Phylo2Vec vector
+ * @param v Phylo2Vec vector (validated, cf. check_v)
  * @return std::vector<std::array<int, 3>>
  * 1st column: parent
  * 2nd and 3rd columns: children
  */
 std::vector<std::array<int, 3>> getAncestry(const std::vector<int> &v);
 
+/**
+ * @brief Add the pair of leaf j + 1 to the pairs of v[0..j-1]
+ * The pairs of v list the merges processed by getAncestry: pair (a, b) merges the subtree
+ * containing leaf a with the subtree containing leaf b. They only depend on a prefix of v, so
+ * they can be updated incrementally when the last entries of v change.
+ *
+ * @param pairs pairs of v[0..j-1] (j pairs), updated in place
+ * @param j index of the new entry of v
+ * @param v_j value of v[j] (throws std::out_of_range unless 0 <= v_j <= 2j)
+ */
+void addPair(std::vector<std::pair<int, int>> &pairs, int j, int v_j);
+
+/**
+ * @brief Pairs of v (cf. addPair), computed in O(k log k)
+ * The insertions of addPair are resolved offline with a Fenwick tree instead of shifting a list.
+ *
+ * @param v Phylo2Vec vector (throws std::out_of_range if invalid, cf. check_v)
+ * @return std::vector<std::pair<int, int>> pairs of v
+ */
+std::vector<std::pair<int, int>> getPairs(const std::vector<int> &v);
+
+/**
+ * @brief Build an "ancestry" array by merging pairs in order
+ *
+ * @param pairs cf. addPair
+ * @return std::vector<std::array<int, 3>> cf. getAncestry
+ */
+std::vector<std::array<int, 3>> getAncestryFromPairs(
+    const std::vector<std::pair<int, int>> &pairs);
+
 /**
  * @brief Build a Newick string from an "ancestry" array to describe a tree
  * M is processed such that we iteratively write a Newick string
@@ -103,6 +138,56 @@ std::string buildNewick(std::vector<std::array<int, 3>> M);
  */
 std::string toNewick(const std::vector<int> &v);
 
+/**
+ * @brief Convert an "ancestry" array back to its Phylo2Vec vector
+ * Inverse of getAncestry, computed on the tree structure directly (no Newick round trip).
+ * Leaves must be labelled 0..k and internal nodes k+1..2k, in any order.
+ *
+ * @param M cf. getAncestry
+ * @return std::vector<int> Phylo2Vec vector of size k
+ */
+std::vector<int> fromAncestry(const std::vector<std::array<int, 3>> &M);
+
+/**
+ * @brief Restrict a tree to a subset of its leaves
+ * Kept leaves are relabelled 0..m-1 following their original order.
+ *
+ * @param v Phylo2Vec vector (k + 1 leaves)
+ * @param keep leaf mask of size k + 1 (at least 2 leaves must be kept)
+ * @return std::vector<int> Phylo2Vec vector of the induced subtree (size m - 1)
+ */
+std::vector<int> getInducedSubtree(const std::vector<int> &v, const std::vector<bool> &keep);
+
+/**
+ * @brief Relabel the kept leaves of a mask to 0..m-1
+ *
+ * @param keep leaf mask
+ * @param num_leaves expected size of the mask
+ * @return std::vector<int> new label of each leaf (-1 if the leaf is dropped)
+ */
+std::vector<int> relabelLeaves(const std::vector<bool> &keep, std::size_t num_leaves);
+
+/**
+ * @brief getInducedSubtree with a pre-computed relabelling of the leaves (cf. relabelLeaves)
+ *
+ * @param v Phylo2Vec vector
+ * @param new_labels new label of each leaf (-1 if the leaf is dropped)
+ * @param num_kept number of kept leaves
+ */
+std::vector<int> getInducedSubtree(const std::vector<int> &v, const std::vector<int> &new_labels,
+                                   int num_kept);
+
+/**
+ * @brief Batch version of getInducedSubtree, sharing the same mask for all trees
+ * Trees are processed in parallel (if compiled with OpenMP).
+ *
+ * @param vs Phylo2Vec vectors, all of size keep.size() - 1
+ * @param keep leaf mask
+ * @return std::vector<std::vector<int>> Phylo2Vec vectors of the induced subtrees
+ */
+std::vector<std::vector<int>> getInducedSubtrees(const std::vector<std::vector<int>> &vs,
+                                                 const std::vector<bool> &keep);
+
 /**
  * @brief remove parent nodes from a Newick string
  * Example: "(((2,1)4,0)5,3)6;" --> "(((2,1),0),3);"
@@ -164,6 +249,7 @@ inline std::vector<std::string> rpartition(const std::string &str, const std::st
 
 /**
  * @brief Find the most inner left leaf
+ * @deprecated O(k) string search per leaf, no longer used by toVector (cf. fromAncestry)
  *
  * @param newick Newick representation of a tree
  * @param labels @todo
@@ -171,22 +257,25 @@ inline std::vector<std::string> rpartition(const std::string &str, const std::st
  * @param num_leaves Number of leaves
  * @return std::pair<int, int> the left leaf + at which iteration it was found
  */
-std::pair<int, int> findLeftLeaf(std::string newick, const std::vector<int> &labels,
-                                 const std::vector<bool> &processed, int num_leaves);
+[[deprecated("no longer used by toVector")]] std::pair<int, int> findLeftLeaf(
+    std::string newick, const std::vector<int> &labels, const std::vector<bool> &processed,
+    int num_leaves);
 
 /**
  * @brief TODO
+ * @deprecated no longer used by toVector (cf. fromAncestry)
  *
  * @param vmin
  * @param right_leaf
  * @param num_leaves
  * @param processed
  */
-void updateVmin(std::vector<int> &vmin, int right_leaf, int num_leaves,
-                const std::vector<bool> &processed);
+[[deprecated("no longer used by toVector")]] void updateVmin(
+    std::vector<int> &vmin, int right_leaf, int num_leaves, const std::vector<bool> &processed);
 
 /**
  * @brief Update the newick string by fusing the left leaf and the right leaf
+ * @deprecated O(k) string search, no longer used by toVector (cf. fromAncestry)
  *
  * @param newick  Newick representation of a tree
  * @param left_leaf_ind @todo
@@ -194,8 +283,9 @@ void updateVmin(std::vector<int> &vmin, int right_leaf, int num_leaves,
  * @param right_leaf @todo
  * @param labels @todo
  */
-void updateNewick(std::string &newick, int left_leaf_ind, int left_leaf, int right_leaf,
-                  const std::vector<int> &labels);
+[[deprecated("no longer used by toVector")]] void updateNewick(
+    std::string &newick, int left_leaf_ind, int left_leaf, int right_leaf,
+    const std::vector<int> &labels);
 
 /**
  * @brief remove annotations related to parent nodes and branch lengths of a Newick string
@@ -204,6 +294,31 @@ void updateNewick(std::string &newick, int left_leaf_ind, int left_leaf, int rig
  */
 void processNewick(std::string &newick);
 
+/**
+ * @brief Parse a Newick string with integer leaves into an "ancestry" array
+ * Parent annotations are ignored. Internal nodes are labelled k+1..2k in the order they are
+ * closed in the Newick string.
+ *
+ * @param newick Newick representation of a tree, with leaves labelled 0..k
+ * @param branch_lengths output: length of the branch above each node (0 if not annotated)
+ * @return std::vector<std::array<int, 3>> cf. getAncestry (the root is on the first row)
+ */
+std::vector<std::array<int, 3>> getAncestryFromNewick(const std::string &newick,
+                                                      std::vector<double> &branch_lengths);
+
+/**
+ * @brief Convert a Newick string with integer leaves to its Phylo2Vec vector in O(n log n)
+ * Wrapper of getAncestryFromNewick + fromAncestry. Unlike newick2v, the output has k entries
+ * (no leading 0) and can be fed back to toNewick.
+ *
+ * @param newick Newick representation of a tree, with leaves labelled 0..k
+ * @param reroot_method how to root the tree first (cf. RerootMethod)
+ * @param outgroup leaf on whose branch to root the tree, for RerootMethod::LEAF
+ * @return std::vector<int> Phylo2Vec vector of size k
+ */
+std::vector<int> fromNewick(const std::string &newick,
+                            RerootMethod reroot_method = RerootMethod::NONE, int outgroup = -1);
+
 /**
  * @brief Convert a newick-format tree to its v representation
  *
@@ -219,9 +334,13 @@ std::vector<int> toVector(std::string newick, int num_leaves);
  * @param newick Newick representation of a tree
  * @param num_leaves Number of leaves
  * Saves some computation time if fed in advance
+ * @param reroot_method how to root the tree first (cf. RerootMethod), e.g. for unrooted trees
+ * @param outgroup leaf label for RerootMethod::LEAF
  * @return Newick2VResult: v and num_leaves
  */
-Newick2VResult newick2v(std::string &newick, int num_leaves = -1);
+Newick2VResult newick2v(std::string &newick, int num_leaves = -1,
+                        RerootMethod reroot_method = RerootMethod::NONE,
+                        const std::string &outgroup = "");
 
 /**
  * @brief Wrapper of processNewick + getNumLeavesFromNewick (if num_leaves == -1) +
@@ -229,8 +348,12 @@ Newick2VResult newick2v(std::string &newick, int num_leaves = -1);
  * integers but "real" taxa (or any string)
  * @param newick Newick representation of a tree
  * @param num_leaves Number of leaves (saves some computation time if fed in advance)
+ * @param reroot_method how to root the tree first (cf. RerootMethod), e.g. for unrooted trees
+ * @param outgroup taxon name for RerootMethod::LEAF
  * @return Newick2VResult: v, num_leaves, and mapping
  */
-Newick2VResult newick2vWithMapping(std::string &newick, int num_leaves);
+Newick2VResult newick2vWithMapping(std::string &newick, int num_leaves,
+                                   RerootMethod reroot_method = RerootMethod::NONE,
+                                   const std::string &outgroup = "");
 
 #endif  // PHYLO2VEC_HPP
\ No newline at end of file
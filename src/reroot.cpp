@@ -0,0 +1,354 @@
+#include "reroot.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+const std::string LABEL_DELIMITERS = ",():;[";
+
+double getBranchLength(const UnrootedTree &tree, int u, int w) {
+    for (const auto &neighbor : tree.neighbors[u]) {
+        if (neighbor.first == w) {
+            return neighbor.second;
+        }
+    }
+    std::ostringstream oss;
+    oss << "Nodes " << u << " and " << w << " are not adjacent.";
+    throw std::invalid_argument(oss.str());
+}
+
+/**
+ * @brief Distances from a source node (iterative traversal)
+ *
+ * @param unit if true, all branches have length 1
+ * @param parents output: parent of each node in the traversal from source
+ * @return std::vector<double> distance of each node to source
+ */
+std::vector<double> getDistances(const UnrootedTree &tree, int source, bool unit,
+                                 std::vector<int> &parents) {
+    const int num_nodes = tree.neighbors.size();
+    std::vector<double> distances(num_nodes, 0.0);
+    parents.assign(num_nodes, -1);
+
+    std::vector<int> stack = {source};
+    while (!stack.empty()) {
+        const int node = stack.back();
+        stack.pop_back();
+        for (const auto &neighbor : tree.neighbors[node]) {
+            if (neighbor.first != parents[node]) {
+                parents[neighbor.first] = node;
+                distances[neighbor.first] = distances[node] + (unit ? 1.0 : neighbor.second);
+                stack.push_back(neighbor.first);
+            }
+        }
+    }
+
+    return distances;
+}
+
+int getFarthestLeaf(const UnrootedTree &tree, const std::vector<double> &distances) {
+    return std::max_element(distances.begin(), distances.begin() + tree.num_leaves) -
+           distances.begin();
+}
+
+}  // namespace
+
+RerootMethod parseRerootMethod(const std::string &name) {
+    if (name == "none") {
+        return RerootMethod::NONE;
+    } else if (name == "resolve") {
+        return RerootMethod::RESOLVE;
+    } else if (name == "leaf") {
+        return RerootMethod::LEAF;
+    } else if (name == "midpoint") {
+        return RerootMethod::MIDPOINT;
+    }
+    std::ostringstream oss;
+    oss << "Unknown reroot method: '" << name << "'. Expected none, resolve, leaf or midpoint.";
+    throw std::invalid_argument(oss.str());
+}
+
+UnrootedTree parseUnrootedNewick(const std::string &newick, std::vector<std::string> *taxa) {
+    // Leaf label (or -1 for internal nodes), parent and branch length of each node, in order of
+    // appearance
+    std::vector<int> labels, parents;
+    std::vector<double> lengths;
+    std::unordered_map<std::string, int> taxon_indices;
+
+    std::vector<int> open_nodes;
+    int last_node = -1;
+    bool has_last_node = false;
+
+    auto addNode = [&](int label) {
+        if (open_nodes.empty() && !labels.empty()) {
+            throw std::invalid_argument("Invalid Newick string: unbalanced parentheses.");
+        }
+        labels.push_back(label);
+        parents.push_back(open_nodes.empty() ? -1 : open_nodes.back());
+        lengths.push_back(0.0);
+        return static_cast<int>(labels.size()) - 1;
+    };
+
+    std::size_t i = 0;
+    const std::size_t n = newick.size();
+    while (i < n && newick[i] != ';') {
+        const char c = newick[i];
+        if (c == '(') {
+            open_nodes.push_back(addNode(-1));
+            has_last_node = false;
+            ++i;
+        } else if (c == ',' || c == ')') {
+            if (open_nodes.empty() || !has_last_node) {
+                throw std::invalid_argument("Invalid Newick string: unbalanced parentheses.");
+            }
+            has_last_node = false;
+            ++i;
+
+            if (c == ')') {
+                last_node = open_nodes.back();
+                open_nodes.pop_back();
+                has_last_node = true;
+
+                // Skip the parent annotation
+                while (i < n && LABEL_DELIMITERS.find(newick[i]) == std::string::npos) {
+                    ++i;
+                }
+            }
+        } else if (c == ':') {
+            if (!has_last_node) {
+                throw std::invalid_argument("Invalid Newick string: misplaced branch length.");
+            }
+            std::size_t end = ++i;
+            while (end < n && LABEL_DELIMITERS.find(newick[end]) == std::string::npos) {
+                ++end;
+            }
+            lengths[last_node] = std::stod(newick.substr(i, end - i));
+            i = end;
+        } else if (c == '[') {
+            const std::size_t end = newick.find(']', i);
+            i = end == std::string::npos ? n : end + 1;
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            ++i;
+        } else {
+            std::size_t end = i;
+            while (end < n && LABEL_DELIMITERS.find(newick[end]) == std::string::npos) {
+                ++end;
+            }
+            std::string label = newick.substr(i, end - i);
+            label.erase(label.find_last_not_of(" \t\r\n") + 1);
+            i = end;
+
+            int leaf;
+            if (taxa) {
+                if (taxon_indices.count(label)) {
+                    throw std::invalid_argument("Invalid Newick string: duplicate leaf " + label +
+                                                ".");
+                }
+                leaf = taxa->size();
+                taxon_indices[label] = leaf;
+                taxa->push_back(label);
+            } else {
+                if (!std::all_of(label.begin(), label.end(),
+                                 [](char ch) { return std::isdigit(ch) != 0; })) {
+                    throw std::invalid_argument("Invalid Newick string: leaf '" + label +
+                                                "' is not an integer. Are the Newick nodes "
+                                                "integers (and not taxa)?");
+                }
+                leaf = std::stoi(label);
+            }
+
+            last_node = addNode(leaf);
+            has_last_node = true;
+        }
+    }
+
+    if (!open_nodes.empty() || !has_last_node) {
+        throw std::invalid_argument("Invalid Newick string: unbalanced parentheses.");
+    }
+
+    // Leaves first, then internal nodes in order of appearance
+    const int num_leaves =
+        std::count_if(labels.begin(), labels.end(), [](int label) { return label >= 0; });
+    std::vector<int> ids(labels.size());
+    std::vector<bool> seen(num_leaves, false);
+    int next_internal = num_leaves;
+    for (std::size_t node = 0; node < labels.size(); ++node) {
+        if (labels[node] < 0) {
+            ids[node] = next_internal++;
+        } else if (labels[node] >= num_leaves || seen[labels[node]]) {
+            std::ostringstream oss;
+            oss << "Invalid Newick string: leaves should be labelled 0.." << num_leaves - 1
+                << " exactly once, found " << labels[node] << ".";
+            throw std::invalid_argument(oss.str());
+        } else {
+            ids[node] = labels[node];
+            seen[labels[node]] = true;
+        }
+    }
+
+    UnrootedTree tree;
+    tree.num_leaves = num_leaves;
+    tree.root = ids[0];
+    tree.neighbors.resize(labels.size());
+    for (std::size_t node = 1; node < labels.size(); ++node) {
+        const int u = ids[node], w = ids[parents[node]];
+        tree.neighbors[u].push_back(std::make_pair(w, lengths[node]));
+        tree.neighbors[w].push_back(std::make_pair(u, lengths[node]));
+    }
+
+    return tree;
+}
+
+std::vector<std::array<int, 3>> rootAtEdge(const UnrootedTree &tree, int u, int w,
+                                           double length_u, std::vector<double> &branch_lengths) {
+    const int k = tree.num_leaves - 1;
+    const int num_nodes = tree.neighbors.size();
+    const double length = getBranchLength(tree, u, w);
+
+    // Rows are created children first (internal labels k+1, k+2, ...), with the root last
+    std::vector<std::array<int, 3>> M;
+    M.reserve(k);
+    branch_lengths.assign(2 * k + 1, 0.0);
+
+    // Label and length of the branch above each processed subtree, once unary nodes (such as a
+    // former root with two children) are suppressed
+    std::vector<int> labels(num_nodes, -1);
+    std::vector<double> lengths(num_nodes, 0.0);
+    std::vector<int> parents(num_nodes, -1);
+
+    auto processSide = [&](int start, int from, double start_length) {
+        // Pre-order traversal, processed in reverse so that children come before parents
+        std::vector<int> order;
+        std::vector<int> stack = {start};
+        parents[start] = from;
+        lengths[start] = start_length;
+        while (!stack.empty()) {
+            const int node = stack.back();
+            stack.pop_back();
+            order.push_back(node);
+            for (const auto &neighbor : tree.neighbors[node]) {
+                if (neighbor.first != parents[node]) {
+                    parents[neighbor.first] = node;
+                    lengths[neighbor.first] = neighbor.second;
+                    stack.push_back(neighbor.first);
+                }
+            }
+        }
+
+        for (auto it = order.rbegin(); it != order.rend(); ++it) {
+            const int node = *it;
+            if (node < tree.num_leaves) {
+                labels[node] = node;
+                continue;
+            }
+
+            std::vector<int> children;
+            for (const auto &neighbor : tree.neighbors[node]) {
+                if (neighbor.first != parents[node]) {
+                    children.push_back(neighbor.first);
+                }
+            }
+
+            if (children.size() == 1) {
+                labels[node] = labels[children[0]];
+                lengths[node] += lengths[children[0]];
+            } else if (children.size() == 2) {
+                const int label = k + 1 + static_cast<int>(M.size());
+                M.push_back({{label, labels[children[0]], labels[children[1]]}});
+                branch_lengths[labels[children[0]]] = lengths[children[0]];
+                branch_lengths[labels[children[1]]] = lengths[children[1]];
+                labels[node] = label;
+            } else {
+                throw std::invalid_argument(
+                    "Invalid Newick string: the tree should be binary (apart from its root).");
+            }
+        }
+    };
+
+    processSide(u, w, length_u);
+    processSide(w, u, length - length_u);
+
+    M.push_back({{k + 1 + static_cast<int>(M.size()), labels[u], labels[w]}});
+    branch_lengths[labels[u]] = lengths[u];
+    branch_lengths[labels[w]] = lengths[w];
+
+    if (static_cast<int>(M.size()) != k) {
+        throw std::invalid_argument("Invalid Newick string: the tree has internal nodes without "
+                                    "children.");
+    }
+
+    // Put the root first (cf. getAncestry)
+    std::reverse(M.begin(), M.end());
+
+    return M;
+}
+
+std::vector<std::array<int, 3>> reroot(const UnrootedTree &tree, RerootMethod method,
+                                       int outgroup, std::vector<double> &branch_lengths) {
+    if (tree.num_leaves < 2) {
+        throw std::invalid_argument("Cannot root a tree with less than 2 leaves.");
+    }
+
+    const auto &root_neighbors = tree.neighbors[tree.root];
+
+    switch (method) {
+        case RerootMethod::NONE:
+        case RerootMethod::RESOLVE: {
+            if (root_neighbors.size() == 3 && method == RerootMethod::RESOLVE) {
+                // ((A,B),C): the root of (A,B,C) stays on the side of A and B
+                return rootAtEdge(tree, tree.root, root_neighbors[2].first, 0.0, branch_lengths);
+            }
+            if (root_neighbors.size() != 2) {
+                std::ostringstream oss;
+                oss << "The root of the tree has " << root_neighbors.size()
+                    << " children: the tree is unrooted or non-binary. Try another reroot method.";
+                throw std::invalid_argument(oss.str());
+            }
+            // Keep the original root
+            return rootAtEdge(tree, tree.root, root_neighbors[1].first, 0.0, branch_lengths);
+        }
+        case RerootMethod::LEAF: {
+            if (outgroup < 0 || outgroup >= tree.num_leaves) {
+                std::ostringstream oss;
+                oss << "Invalid outgroup leaf " << outgroup << ": the tree has "
+                    << tree.num_leaves << " leaves.";
+                throw std::out_of_range(oss.str());
+            }
+            const auto &neighbor = tree.neighbors[outgroup][0];
+            return rootAtEdge(tree, outgroup, neighbor.first, neighbor.second / 2, branch_lengths);
+        }
+        case RerootMethod::MIDPOINT: {
+            // Without branch lengths, count branches
+            bool unit = true;
+            for (const auto &neighbors : tree.neighbors) {
+                for (const auto &neighbor : neighbors) {
+                    unit = unit && neighbor.second == 0.0;
+                }
+            }
+
+            // Longest path between two leaves a and b: a is the farthest leaf from any leaf,
+            // b is the farthest leaf from a
+            std::vector<int> parents;
+            const int a = getFarthestLeaf(tree, getDistances(tree, 0, unit, parents));
+            const std::vector<double> distances = getDistances(tree, a, unit, parents);
+            const int b = getFarthestLeaf(tree, distances);
+            const double half = distances[b] / 2;
+
+            // Walk from b towards a until the branch containing the midpoint
+            int node = b;
+            while (distances[parents[node]] > half) {
+                node = parents[node];
+            }
+
+            // Without branch lengths, all output lengths stay 0
+            const double length_node = unit ? 0.0 : distances[node] - half;
+            return rootAtEdge(tree, node, parents[node], length_node, branch_lengths);
+        }
+    }
+
+    throw std::invalid_argument("Unknown reroot method.");
+}
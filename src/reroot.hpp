@@ -0,0 +1,80 @@
+#ifndef REROOT_HPP
+#define REROOT_HPP
+
+#include <array>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Rerooting of Newick trees, e.g. unrooted trees from RAxML/IQ-TREE written with a root
+ * trifurcation: "(A,B,(C,D));"
+ *
+ * The Newick string is parsed once into an unrooted tree (the original root is suppressed if it
+ * has two children), then a root is placed on an edge and the "ancestry" array is built by a
+ * single traversal, so all operations are O(n).
+ */
+
+/**
+ * @brief How to root a tree before converting it
+ * NONE: the tree must be rooted and binary
+ * RESOLVE: resolve a root trifurcation (A,B,C) -> ((A,B),C) with a zero-length branch
+ * LEAF: root on the branch of a given leaf (outgroup), at half its length
+ * MIDPOINT: root at the middle of the longest leaf-to-leaf path (in number of branches if the
+ * tree has no branch lengths)
+ */
+enum class RerootMethod { NONE, RESOLVE, LEAF, MIDPOINT };
+
+/**
+ * @brief Parse a reroot method name: "none", "resolve", "leaf" or "midpoint"
+ */
+RerootMethod parseRerootMethod(const std::string &name);
+
+/**
+ * @brief Tree of a Newick string, seen as an unrooted graph
+ * num_leaves: leaves are the nodes 0..num_leaves-1, internal nodes follow
+ * root: root of the Newick string
+ * neighbors: (neighbor, branch length) of each node
+ */
+struct UnrootedTree {
+    int num_leaves;
+    int root;
+    std::vector<std::vector<std::pair<int, double>>> neighbors;
+};
+
+/**
+ * @brief Parse a Newick string with any node degrees (parent labels are ignored)
+ *
+ * @param newick Newick string
+ * @param taxa if null, leaves should be integers 0..n-1. Otherwise, leaves can be any label and
+ * are numbered in order of appearance (like integerizeChildNodes); taxa receives their names.
+ * @return UnrootedTree parsed tree
+ */
+UnrootedTree parseUnrootedNewick(const std::string &newick,
+                                 std::vector<std::string> *taxa = nullptr);
+
+/**
+ * @brief Root a tree on the branch between u and w
+ *
+ * @param tree cf. parseUnrootedNewick
+ * @param u, w adjacent nodes
+ * @param length_u length of the new branch between the root and u (the rest goes to w)
+ * @param branch_lengths output: length of the branch above each node (cf. getAncestryFromNewick)
+ * @return std::vector<std::array<int, 3>> cf. getAncestry
+ */
+std::vector<std::array<int, 3>> rootAtEdge(const UnrootedTree &tree, int u, int w,
+                                           double length_u, std::vector<double> &branch_lengths);
+
+/**
+ * @brief Root a tree with a given method (cf. RerootMethod)
+ *
+ * @param tree cf. parseUnrootedNewick
+ * @param method rerooting method
+ * @param outgroup leaf for RerootMethod::LEAF
+ * @param branch_lengths output: length of the branch above each node
+ * @return std::vector<std::array<int, 3>> cf. getAncestry
+ */
+std::vector<std::array<int, 3>> reroot(const UnrootedTree &tree, RerootMethod method,
+                                       int outgroup, std::vector<double> &branch_lengths);
+
+#endif  // REROOT_HPP
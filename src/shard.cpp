@@ -0,0 +1,435 @@
+#include "shard.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#include "compression.hpp"
+#include "npy.hpp"
+
+namespace {
+
+std::string lowerWord(const std::string &str, std::size_t pos) {
+    while (pos < str.size() && std::isspace(static_cast<unsigned char>(str[pos]))) {
+        ++pos;
+    }
+    std::string word;
+    while (pos < str.size() && std::isalpha(static_cast<unsigned char>(str[pos]))) {
+        word += std::tolower(static_cast<unsigned char>(str[pos]));
+        ++pos;
+    }
+    return word;
+}
+
+std::string quoteName(const std::string &name) {
+    std::string quoted = "'";
+    for (char c : name) {
+        quoted += c;
+        if (c == '\'') {
+            quoted += '\'';
+        }
+    }
+    return quoted + "'";
+}
+
+std::uint64_t getFileSize(std::ifstream &file) {
+    file.seekg(0, std::ios::end);
+    const std::uint64_t size = file.tellg();
+    file.seekg(0);
+    return size;
+}
+
+std::ifstream openInput(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Could not open " + path + ".");
+    }
+    unsigned char magic[4] = {0, 0, 0, 0};
+    file.read(reinterpret_cast<char *>(magic), sizeof(magic));
+    const std::size_t magic_size = file.gcount();
+    file.clear();
+    file.seekg(0);
+    if (detectCompression(magic, magic_size) != Compression::NONE) {
+        throw std::runtime_error("Cannot split compressed file " + path +
+                                 " by byte offset: decompress it first.");
+    }
+    return file;
+}
+
+/**
+ * @brief Start of the first line at or after pos that starts a tree statement or ends the TREES
+ * block (or the end of the file)
+ */
+std::uint64_t alignToTree(std::ifstream &file, std::uint64_t pos, std::uint64_t file_size) {
+    file.clear();
+    if (pos > 0) {
+        // Skip the end of the line containing pos, unless pos starts a line
+        file.seekg(pos - 1);
+        std::string rest;
+        std::getline(file, rest);
+        pos += rest.size();
+    } else {
+        file.seekg(0);
+    }
+
+    std::string line;
+    while (pos < file_size && std::getline(file, line)) {
+        const std::string word = lowerWord(line, 0);
+        if (word == "tree" || word == "utree" || word == "end" || word == "endblock") {
+            return pos;
+        }
+        pos += line.size() + 1;
+    }
+
+    return file_size;
+}
+
+/**
+ * @brief Stream buffer serving a sequence of strings and byte ranges of a file
+ */
+class SegmentStreambuf : public std::streambuf {
+   public:
+    explicit SegmentStreambuf(const std::string &path)
+        : file_(path, std::ios::binary), buffer_(1 << 20), segment_(0), offset_(0) {
+        if (!file_) {
+            throw std::runtime_error("Could not open " + path + ".");
+        }
+    }
+
+    void addText(const std::string &text) { segments_.push_back(Segment{text, 0, 0, true}); }
+    void addRange(std::uint64_t begin, std::uint64_t end) {
+        segments_.push_back(Segment{"", begin, end, false});
+    }
+
+   protected:
+    int_type underflow() override {
+        while (segment_ < segments_.size()) {
+            const Segment &segment = segments_[segment_];
+
+            std::size_t size;
+            if (segment.is_text) {
+                size = std::min<std::size_t>(buffer_.size(), segment.text.size() - offset_);
+                std::memcpy(buffer_.data(), segment.text.data() + offset_, size);
+            } else {
+                size = std::min<std::uint64_t>(buffer_.size(),
+                                               segment.end - segment.begin - offset_);
+                if (offset_ == 0) {
+                    file_.seekg(segment.begin);
+                }
+                file_.read(buffer_.data(), size);
+                if (static_cast<std::size_t>(file_.gcount()) != size) {
+                    throw std::runtime_error("Unexpected end of file while reading a shard.");
+                }
+            }
+
+            if (size == 0) {
+                ++segment_;
+                offset_ = 0;
+                continue;
+            }
+
+            offset_ += size;
+            setg(buffer_.data(), buffer_.data(), buffer_.data() + size);
+            return traits_type::to_int_type(buffer_[0]);
+        }
+
+        return traits_type::eof();
+    }
+
+   private:
+    struct Segment {
+        std::string text;
+        std::uint64_t begin;
+        std::uint64_t end;
+        bool is_text;
+    };
+
+    std::ifstream file_;
+    std::vector<char> buffer_;
+    std::vector<Segment> segments_;
+    std::size_t segment_;
+    std::uint64_t offset_;
+};
+
+/**
+ * @brief Absolute path of an existing file (POSIX realpath: C++14 has no std::filesystem)
+ */
+std::string getAbsolutePath(const std::string &path) {
+    std::unique_ptr<char, decltype(&std::free)> resolved(realpath(path.c_str(), nullptr),
+                                                         &std::free);
+    if (!resolved) {
+        throw std::runtime_error("Could not resolve the path of " + path + ".");
+    }
+    return resolved.get();
+}
+
+bool endsWith(const std::string &str, const std::string &suffix) {
+    return str.size() >= suffix.size() &&
+           str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+}  // namespace
+
+ShardManifest partitionTrees(const std::string &path, int num_shards) {
+    if (num_shards <= 0) {
+        throw std::invalid_argument("The number of shards should be positive.");
+    }
+
+    std::ifstream file = openInput(path);
+
+    ShardManifest manifest;
+    // Shards may be processed on other nodes or from other working directories
+    manifest.input = getAbsolutePath(path);
+    manifest.file_size = getFileSize(file);
+
+    // #NEXUS (checked by NexusReader below)
+    std::string word;
+    file >> word;
+    manifest.header_begin = file.tellg();
+
+    // Find the first tree statement, skipping comments and quoted labels
+    std::uint64_t pos = manifest.header_begin;
+    std::uint64_t statement_begin = pos;
+    std::uint64_t first_tree_end = manifest.file_size;
+    manifest.header_end = manifest.file_size;
+
+    std::string statement, block;
+    int depth = 0;
+    bool in_quotes = false;
+    char c;
+    while (file.get(c)) {
+        ++pos;
+        if (in_quotes) {
+            in_quotes = c != '\'';
+        } else if (c == '[') {
+            ++depth;
+        } else if (depth > 0) {
+            depth -= c == ']';
+        } else if (c == '\'') {
+            in_quotes = true;
+        } else if (c == ';') {
+            std::istringstream iss(statement);
+            std::string command, name;
+            iss >> command >> name;
+            command = lowerWord(command, 0);
+            if (command == "begin") {
+                block = lowerWord(name, 0);
+            } else if (command == "end" || command == "endblock") {
+                block.clear();
+            } else if ((command == "tree" || command == "utree") && block == "trees") {
+                manifest.header_end = statement_begin;
+                first_tree_end = pos;
+                break;
+            }
+            statement.clear();
+            statement_begin = pos;
+        } else if (statement.size() < 64) {
+            // The first words are enough to identify the statement
+            statement += c;
+        }
+    }
+
+    // Taxon table, as seen by a NexusReader on the whole file
+    {
+        file.clear();
+        file.seekg(0);
+        std::string head(first_tree_end, '\0');
+        file.read(&head[0], head.size());
+        std::istringstream iss(head + "\nend;\n");
+        NexusReader reader(iss);
+        NexusTree tree;
+        reader.next(tree);
+        manifest.taxa = reader.taxa();
+    }
+
+    // Shards of similar byte size, aligned on tree statements
+    const std::uint64_t trees_size = manifest.file_size - manifest.header_end;
+    std::uint64_t begin = manifest.header_end;
+    for (int i = 1; i <= num_shards; ++i) {
+        std::uint64_t end = manifest.file_size;
+        if (i < num_shards) {
+            const std::uint64_t target = manifest.header_end + trees_size * i / num_shards;
+            end = std::max(begin, alignToTree(file, target, manifest.file_size));
+        }
+        manifest.shards.push_back(std::make_pair(begin, end));
+        begin = end;
+    }
+
+    return manifest;
+}
+
+void writeManifest(const ShardManifest &manifest, std::ostream &out) {
+    out << SHARD_MANIFEST_MAGIC << " " << SHARD_MANIFEST_VERSION << "\n";
+    out << "input " << manifest.input << "\n";
+    out << "size " << manifest.file_size << "\n";
+    out << "header " << manifest.header_begin << " " << manifest.header_end << "\n";
+    out << "taxa " << manifest.taxa.size() << "\n";
+    for (const auto &taxon : manifest.taxa) {
+        out << taxon << "\n";
+    }
+    out << "shards " << manifest.shards.size() << "\n";
+    for (const auto &shard : manifest.shards) {
+        out << shard.first << " " << shard.second << "\n";
+    }
+}
+
+ShardManifest readManifest(std::istream &in) {
+    auto fail = [](const std::string &message) {
+        throw std::runtime_error("Invalid shard manifest: " + message + ".");
+    };
+    auto expectKey = [&](const std::string &key) {
+        std::string word;
+        if (!(in >> word) || word != key) {
+            fail("expected '" + key + "'");
+        }
+    };
+
+    ShardManifest manifest;
+
+    std::string magic;
+    int version;
+    if (!(in >> magic >> version) || magic != SHARD_MANIFEST_MAGIC) {
+        fail("bad magic");
+    }
+    if (version != SHARD_MANIFEST_VERSION) {
+        std::ostringstream oss;
+        oss << "unsupported version " << version;
+        fail(oss.str());
+    }
+
+    expectKey("input");
+    in.ignore(1);
+    std::getline(in, manifest.input);
+
+    std::size_t num_taxa, num_shards;
+    expectKey("size");
+    in >> manifest.file_size;
+    expectKey("header");
+    in >> manifest.header_begin >> manifest.header_end;
+    expectKey("taxa");
+    if (!(in >> num_taxa)) {
+        fail("bad number of taxa");
+    }
+    in.ignore(1);
+    manifest.taxa.resize(num_taxa);
+    for (auto &taxon : manifest.taxa) {
+        std::getline(in, taxon);
+    }
+
+    expectKey("shards");
+    if (!(in >> num_shards)) {
+        fail("bad number of shards");
+    }
+    manifest.shards.resize(num_shards);
+    for (auto &shard : manifest.shards) {
+        in >> shard.first >> shard.second;
+    }
+
+    if (!in) {
+        fail("truncated file");
+    }
+
+    return manifest;
+}
+
+std::string getShardPath(const std::string &output, int shard_id) {
+    const std::string suffix = ".shard" + std::to_string(shard_id);
+
+    const std::size_t slash = output.find_last_of("/\\");
+    const std::size_t basename = slash == std::string::npos ? 0 : slash + 1;
+    const std::size_t dot = output.rfind('.');
+
+    if (dot == std::string::npos || dot <= basename) {
+        return output + suffix;
+    }
+    return output.substr(0, dot) + suffix + output.substr(dot);
+}
+
+ShardReader::ShardReader(const ShardManifest &manifest, int shard_id) {
+    if (shard_id < 0 || shard_id >= static_cast<int>(manifest.shards.size())) {
+        std::ostringstream oss;
+        oss << "Invalid shard id " << shard_id << ": the manifest has " << manifest.shards.size()
+            << " shards.";
+        throw std::out_of_range(oss.str());
+    }
+
+    {
+        std::ifstream file = openInput(manifest.input);
+        if (getFileSize(file) != manifest.file_size) {
+            throw std::runtime_error("Input file " + manifest.input +
+                                     " has changed since it was partitioned.");
+        }
+    }
+
+    // The shared taxon table comes first, so that leaves are numbered as in the whole file even
+    // if the original taxon table was defined by the first tree
+    std::string taxa = "#NEXUS\nbegin taxa;\ntaxlabels";
+    for (const auto &taxon : manifest.taxa) {
+        taxa += " " + quoteName(taxon);
+    }
+    taxa += ";\nend;\n";
+
+    SegmentStreambuf *buf = new SegmentStreambuf(manifest.input);
+    buf_.reset(buf);
+    buf->addText(taxa);
+    buf->addRange(manifest.header_begin, manifest.header_end);
+    buf->addRange(manifest.shards[shard_id].first, manifest.shards[shard_id].second);
+    buf->addText("\nend;\n");
+
+    in_.reset(new std::istream(buf));
+    in_->exceptions(std::ios::badbit);
+    reader_.reset(new NexusReader(*in_));
+}
+
+ShardReader::~ShardReader() {}
+
+std::size_t mergeShardOutputs(const ShardManifest &manifest, const std::string &output) {
+    std::size_t num_trees = 0;
+
+    if (endsWith(output, ".npy")) {
+        std::unique_ptr<NpyWriter> writer;
+        std::vector<std::size_t> row_shape;
+        NpyDtype dtype = NpyDtype::INT32;
+
+        for (std::size_t i = 0; i < manifest.shards.size(); ++i) {
+            const std::string path = getShardPath(output, i);
+            MappedNpy shard(path);
+            std::vector<std::size_t> shard_row_shape(shard.shape().begin() + 1,
+                                                     shard.shape().end());
+            if (!writer) {
+                row_shape = shard_row_shape;
+                dtype = shard.dtype();
+                writer.reset(new NpyWriter(output, row_shape, dtype));
+            } else if (shard_row_shape != row_shape || shard.dtype() != dtype) {
+                throw std::runtime_error("Shard output " + path +
+                                         " does not match the row shape or dtype of shard 0.");
+            }
+
+            for (std::size_t row = 0; row < shard.num_rows(); ++row) {
+                writer->write(shard.getRow(row).data());
+            }
+            num_trees += shard.num_rows();
+        }
+
+        if (writer) {
+            writer->close();
+        }
+    } else {
+        CompressedOfstream out(output);
+        std::string line;
+        for (std::size_t i = 0; i < manifest.shards.size(); ++i) {
+            CompressedIfstream in(getShardPath(output, i));
+            while (std::getline(in, line)) {
+                out << line << "\n";
+                num_trees += !line.empty();
+            }
+        }
+        out.close();
+    }
+
+    return num_trees;
+}
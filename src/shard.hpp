@@ -0,0 +1,112 @@
+#ifndef SHARD_HPP
+#define SHARD_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "nexus.hpp"
+
+/**
+ * Shard-and-merge processing of large NEXUS tree files
+ *
+ * 1. partitionTrees splits the TREES block of a file into byte ranges of similar size, aligned on
+ *    tree statements, and records them in a manifest together with the taxon table.
+ * 2. Each shard is converted independently (e.g., on a different node) with a ShardReader.
+ * 3. mergeShardOutputs concatenates the outputs of all shards in their original order.
+ *
+ * Only the local filesystem is needed: the manifest and the shard outputs are plain files.
+ * Tree statements must start on their own line (as written by MrBayes, BEAST, RevBayes...).
+ */
+
+const char SHARD_MANIFEST_MAGIC[] = "P2VS";
+const int SHARD_MANIFEST_VERSION = 1;
+
+/**
+ * @brief Description of the shards of a NEXUS file
+ * input: absolute path of the NEXUS file (uncompressed)
+ * file_size: size of the file when it was partitioned (to detect modifications)
+ * header_begin, header_end: byte range of the blocks preceding the first tree (without #NEXUS)
+ * taxa: taxon table shared by all shards
+ * shards: byte range [begin, end) of each shard
+ */
+struct ShardManifest {
+    std::string input;
+    std::uint64_t file_size;
+    std::uint64_t header_begin;
+    std::uint64_t header_end;
+    std::vector<std::string> taxa;
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> shards;
+};
+
+/**
+ * @brief Split the trees of a NEXUS file into shards of similar byte size
+ *
+ * @param path uncompressed NEXUS file (compressed files cannot be split by byte offset)
+ * @param num_shards number of shards
+ * @return ShardManifest manifest of the shards
+ */
+ShardManifest partitionTrees(const std::string &path, int num_shards);
+
+/**
+ * @brief Write a manifest (text format)
+ */
+void writeManifest(const ShardManifest &manifest, std::ostream &out);
+
+/**
+ * @brief Read a manifest written by writeManifest
+ */
+ShardManifest readManifest(std::istream &in);
+
+/**
+ * @brief Path of the output of a shard: ".shard<id>" is inserted before the extension of the
+ * final output (e.g., trees.npy -> trees.shard3.npy, trees.txt.gz -> trees.txt.shard3.gz)
+ */
+std::string getShardPath(const std::string &output, int shard_id);
+
+/**
+ * @brief Streaming reader of the trees of one shard
+ * Leaves are numbered according to the taxon table of the manifest, like for the whole file.
+ */
+class ShardReader {
+   public:
+    /**
+     * @param manifest cf. partitionTrees
+     * @param shard_id index of the shard
+     */
+    ShardReader(const ShardManifest &manifest, int shard_id);
+    ~ShardReader();
+
+    /**
+     * @brief Read the next tree of the shard
+     *
+     * @param tree output tree
+     * @return false if there are no trees left
+     */
+    bool next(NexusTree &tree) { return reader_->next(tree); }
+
+    const std::vector<std::string> &taxa() const { return reader_->taxa(); }
+
+   private:
+    std::unique_ptr<std::streambuf> buf_;
+    std::unique_ptr<std::istream> in_;
+    std::unique_ptr<NexusReader> reader_;
+};
+
+/**
+ * @brief Concatenate the outputs of all shards (cf. getShardPath) in order
+ * Outputs are either .npy arrays (with the same row shape and dtype) or text files, possibly
+ * compressed.
+ *
+ * @param manifest cf. partitionTrees
+ * @param output final output
+ * @return std::size_t number of merged trees (rows or lines)
+ */
+std::size_t mergeShardOutputs(const ShardManifest &manifest, const std::string &output);
+
+#endif  // SHARD_HPP
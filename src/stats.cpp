@@ -0,0 +1,97 @@
+#include "stats.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "phylo2vec.hpp"
+
+TreeStats getTreeStats(const std::vector<std::array<int, 3>> &M, int *depths) {
+    const int k = M.size();
+
+    TreeStats stats = {0, 0, 0, 0, {}};
+
+    if (k == 0) {
+        depths[0] = 0;
+        return stats;
+    }
+
+    // Number of leaves below each node
+    // Rows of M are stored from the root: iterate backwards to visit children first
+    std::vector<int> num_leaves(2 * k + 1, 1);
+    for (auto it = M.rbegin(); it != M.rend(); ++it) {
+        const int parent = (*it)[0], child1 = (*it)[1], child2 = (*it)[2];
+
+        num_leaves[parent] = num_leaves[child1] + num_leaves[child2];
+
+        stats.colless += std::abs(num_leaves[child1] - num_leaves[child2]);
+
+        if (child1 <= k && child2 <= k) {
+            stats.cherries++;
+        }
+    }
+
+    // Depth of each node, from the root down
+    std::vector<int> node_depths(2 * k + 1, 0);
+    for (const auto &row : M) {
+        for (int j = 1; j < 3; ++j) {
+            const int child = row[j];
+            const int depth = node_depths[row[0]] + 1;
+
+            node_depths[child] = depth;
+
+            if (child <= k) {
+                depths[child] = depth;
+                stats.sackin += depth;
+                stats.height = std::max(stats.height, depth);
+            }
+        }
+    }
+
+    return stats;
+}
+
+TreeStats getTreeStats(const std::vector<int> &v) {
+    check_v(v);
+
+    std::vector<int> depths(v.size() + 1);
+
+    TreeStats stats = getTreeStats(getAncestry(v), depths.data());
+    stats.depths = depths;
+
+    return stats;
+}
+
+TreeStatsBatch getTreeStats(const std::vector<std::vector<int>> &vs) {
+    const std::size_t num_trees = vs.size();
+
+    // Validate everything first: exceptions cannot leave a parallel region
+    for (const auto &v : vs) {
+        check_v(v);
+    }
+
+    TreeStatsBatch batch;
+    batch.sackin.resize(num_trees);
+    batch.colless.resize(num_trees);
+    batch.cherries.resize(num_trees);
+    batch.height.resize(num_trees);
+    batch.depth_offsets.resize(num_trees + 1, 0);
+
+    for (std::size_t i = 0; i < num_trees; ++i) {
+        batch.depth_offsets[i + 1] = batch.depth_offsets[i] + vs[i].size() + 1;
+    }
+
+    batch.depths.resize(batch.depth_offsets[num_trees]);
+
+#pragma omp parallel for schedule(dynamic)
+    for (std::size_t i = 0; i < num_trees; ++i) {
+        TreeStats stats =
+            getTreeStats(getAncestry(vs[i]), batch.depths.data() + batch.depth_offsets[i]);
+
+        batch.sackin[i] = stats.sackin;
+        batch.colless[i] = stats.colless;
+        batch.cherries[i] = stats.cherries;
+        batch.height[i] = stats.height;
+    }
+
+    return batch;
+}
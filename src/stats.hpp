@@ -0,0 +1,62 @@
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Tree-shape statistics of a single tree
+ * sackin: sum of the leaf depths
+ * colless: sum over internal nodes of |#leaves left - #leaves right|
+ * cherries: number of internal nodes whose children are both leaves
+ * height: maximum leaf depth (in edges)
+ * depths: depth of each leaf (in edges)
+ */
+struct TreeStats {
+    std::int64_t sackin;
+    std::int64_t colless;
+    int cherries;
+    int height;
+    std::vector<int> depths;
+};
+
+/**
+ * @brief Tree-shape statistics of a batch of trees, stored column by column
+ * The depths of tree i are stored in depths[depth_offsets[i]:depth_offsets[i + 1]]
+ */
+struct TreeStatsBatch {
+    std::vector<std::int64_t> sackin;
+    std::vector<std::int64_t> colless;
+    std::vector<int> cherries;
+    std::vector<int> height;
+    std::vector<int> depths;
+    std::vector<std::size_t> depth_offsets;
+};
+
+/**
+ * @brief Compute tree-shape statistics from an ancestry array
+ * Leaf counts are accumulated from the leaves up, depths from the root down
+ *
+ * @param M cf. getAncestry
+ * @param depths output: depth of each leaf, must have M.size() + 1 entries
+ * @return TreeStats statistics (with empty depths)
+ */
+TreeStats getTreeStats(const std::vector<std::array<int, 3>> &M, int *depths);
+
+/**
+ * @brief Compute tree-shape statistics of a Phylo2Vec vector
+ *
+ * @param v Phylo2Vec vector
+ */
+TreeStats getTreeStats(const std::vector<int> &v);
+
+/**
+ * @brief Compute tree-shape statistics of a batch of Phylo2Vec vectors
+ * Trees are processed in parallel (if compiled with OpenMP).
+ *
+ * @param vs Phylo2Vec vectors (can be of different sizes)
+ */
+TreeStatsBatch getTreeStats(const std::vector<std::vector<int>> &vs);
+
+#endif  // STATS_HPP
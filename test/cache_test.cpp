@@ -0,0 +1,177 @@
+#include "../src/cache.hpp"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "../src/phylo2vec.hpp"
+
+TEST(CacheTest, TestNormalizeNewick) {
+    EXPECT_EQ(normalizeNewick("(((2:0.5,1:1e-3)4:0.2,0)5, 3)6;"), "(((2,1),0),3);");
+    EXPECT_EQ(normalizeNewick("((a,b)[&R=0.9]x:1,c[comment]);"), "((a,b),c);");
+    EXPECT_EQ(normalizeNewick("(((2,1),0),3);"), "(((2,1),0),3);");
+}
+
+TEST(CacheTest, TestToNewick) {
+    ConversionCache cache;
+
+    for (int k = 1; k < 50; ++k) {
+        std::vector<int> v = sample(k);
+        EXPECT_EQ(cache.toNewick(v), toNewick(v));
+        EXPECT_EQ(cache.toNewick(v), toNewick(v));
+    }
+
+    CacheStats stats = cache.stats();
+    EXPECT_EQ(stats.hits, 49u);
+    EXPECT_EQ(stats.misses, 49u);
+    EXPECT_EQ(stats.evictions, 0u);
+    EXPECT_EQ(stats.entries, 49u);
+    EXPECT_GT(stats.bytes, 0u);
+
+    EXPECT_THROW(cache.toNewick({0, 5, 1}), std::out_of_range);
+}
+
+TEST(CacheTest, TestNewickToVector) {
+    ConversionCache cache;
+
+    std::vector<int> v = sample(20);
+    std::string newick = toNewick(v);
+    std::string annotated = newick;
+    annotated.insert(annotated.size() - 1, ":0.5");
+
+    EXPECT_EQ(cache.fromNewick(newick), v);
+    // Same topology, same entry
+    EXPECT_EQ(cache.fromNewick(annotated), v);
+
+    std::string copy = newick;
+    std::vector<int> expected = newick2v(copy).v;
+    EXPECT_EQ(cache.newick2v(newick).v, expected);
+    EXPECT_EQ(cache.newick2v(annotated).v, expected);
+
+    CacheStats stats = cache.stats();
+    EXPECT_EQ(stats.hits, 2u);
+    EXPECT_EQ(stats.misses, 2u);
+    EXPECT_EQ(stats.entries, 2u);
+
+    // A cached topology does not bypass the leaf count check
+    EXPECT_EQ(cache.newick2v(newick, 21).v, expected);
+    EXPECT_THROW(cache.newick2v(newick, 10), std::out_of_range);
+
+    EXPECT_THROW(cache.fromNewick("((0,1),2"), std::invalid_argument);
+}
+
+TEST(CacheTest, TestEviction) {
+    // Single shard: strict LRU order
+    const std::size_t max_bytes = 4096;
+    ShardedLRUCache<std::string> cache(max_bytes, 1);
+
+    for (int i = 0; i < 100; ++i) {
+        std::string key = std::to_string(i);
+        cache.put(key, hashBytes(key), std::string(100, 'x'), 100);
+
+        std::string value;
+        // Keep the first entry alive
+        EXPECT_TRUE(cache.get("0", hashBytes("0"), value));
+    }
+
+    CacheStats stats = cache.stats();
+    EXPECT_LE(stats.bytes, max_bytes);
+    EXPECT_GT(stats.evictions, 0u);
+    EXPECT_EQ(stats.entries + stats.evictions, 100u);
+
+    std::string value;
+    EXPECT_TRUE(cache.get("99", hashBytes("99"), value));
+    EXPECT_FALSE(cache.get("1", hashBytes("1"), value));
+
+    // Too large for the budget
+    cache.put("large", hashBytes("large"), std::string(max_bytes, 'x'), max_bytes);
+    EXPECT_FALSE(cache.get("large", hashBytes("large"), value));
+
+    cache.clear();
+    EXPECT_EQ(cache.stats().entries, 0u);
+    EXPECT_EQ(cache.stats().bytes, 0u);
+}
+
+TEST(CacheTest, TestReroot) {
+    ConversionCache cache;
+
+    const std::string unrooted = "(0,1,(2,3));";
+    EXPECT_EQ(cache.fromNewick(unrooted, RerootMethod::RESOLVE), fromNewick("((0,1),(2,3));"));
+    // Entries of other methods or outgroups are not reused
+    EXPECT_THROW(cache.fromNewick(unrooted), std::invalid_argument);
+    EXPECT_EQ(cache.fromNewick(unrooted, RerootMethod::LEAF, 3), fromNewick("(3,(2,(0,1)));"));
+    EXPECT_EQ(cache.fromNewick(unrooted, RerootMethod::LEAF, 0), fromNewick("(0,(1,(2,3)));"));
+
+    // Midpoint rooting depends on branch lengths, not only on the topology
+    EXPECT_EQ(cache.fromNewick("((0:1,1:1):1,(2:1,3:5):1);", RerootMethod::MIDPOINT),
+              fromNewick("(3,((0,1),2));"));
+    EXPECT_EQ(cache.fromNewick("((0:5,1:1):1,(2:1,3:1):1);", RerootMethod::MIDPOINT),
+              fromNewick("(0,(1,(2,3)));"));
+
+    Newick2VResult result = cache.newick2v(unrooted, -1, RerootMethod::LEAF, "3");
+    std::string copy = unrooted;
+    EXPECT_EQ(result.v, newick2v(copy, -1, RerootMethod::LEAF, "3").v);
+    EXPECT_EQ(cache.newick2v(unrooted, -1, RerootMethod::LEAF, "3").v, result.v);
+}
+
+TEST(CacheTest, TestHashCollision) {
+    ShardedLRUCache<int> cache(1 << 20, 4);
+    cache.put("a", 42, 1, sizeof(int));
+    cache.put("b", 42, 2, sizeof(int));
+
+    int value = 0;
+    EXPECT_TRUE(cache.get("a", 42, value));
+    EXPECT_EQ(value, 1);
+    EXPECT_TRUE(cache.get("b", 42, value));
+    EXPECT_EQ(value, 2);
+    EXPECT_FALSE(cache.get("c", 42, value));
+}
+
+TEST(CacheTest, TestBypass) {
+    ConversionCache cache;
+    cache.setBypass(true);
+
+    std::vector<int> v = sample(10);
+    EXPECT_EQ(cache.toNewick(v), toNewick(v));
+    EXPECT_EQ(cache.toNewick(v), toNewick(v));
+
+    CacheStats stats = cache.stats();
+    EXPECT_EQ(stats.hits, 0u);
+    EXPECT_EQ(stats.misses, 0u);
+    EXPECT_EQ(stats.entries, 0u);
+}
+
+TEST(CacheTest, TestConcurrentAccess) {
+    // Small budget to exercise evictions under contention
+    ConversionCache cache(64 << 10, 4);
+
+    std::vector<std::vector<int>> vs;
+    std::vector<std::string> newicks;
+    for (int i = 0; i < 200; ++i) {
+        vs.push_back(sample(30));
+        newicks.push_back(toNewick(vs.back()));
+    }
+
+    std::vector<int> errors(8, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < 2000; ++i) {
+                const int j = (i * 7 + t * 13) % vs.size();
+                if (cache.toNewick(vs[j]) != newicks[j] || cache.fromNewick(newicks[j]) != vs[j]) {
+                    ++errors[t];
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    for (int e : errors) {
+        EXPECT_EQ(e, 0);
+    }
+    CacheStats stats = cache.stats();
+    EXPECT_EQ(stats.hits + stats.misses, 8u * 2000u * 2u);
+    EXPECT_LE(stats.bytes, static_cast<std::size_t>(64 << 10));
+}
@@ -0,0 +1,136 @@
+#include "../src/chain.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <sstream>
+
+#include "../src/phylo2vec.hpp"
+
+/**
+ * @brief Simulate an MCMC chain: each sample changes a few entries of the previous one
+ */
+std::vector<std::vector<int>> sampleChain(int k, int num_samples, int max_changes) {
+    std::mt19937 gen(k);
+    std::vector<std::vector<int>> vs = {sample(k)};
+
+    for (int s = 1; s < num_samples; ++s) {
+        std::vector<int> v = vs.back();
+        int num_changes = std::uniform_int_distribution<>(0, max_changes)(gen);
+        for (int c = 0; c < num_changes; ++c) {
+            int i = std::uniform_int_distribution<>(0, k - 1)(gen);
+            v[i] = std::uniform_int_distribution<>(0, 2 * i)(gen);
+        }
+        vs.push_back(v);
+    }
+
+    return vs;
+}
+
+TEST(ChainTest, TestRoundTrip) {
+    for (int interval : {1, 7, 64}) {
+        std::vector<std::vector<int>> vs = sampleChain(100, 500, 3);
+
+        EXPECT_EQ(decodeChain(encodeChain(vs, interval)), vs);
+    }
+
+    EXPECT_TRUE(decodeChain(encodeChain({})).empty());
+}
+
+TEST(ChainTest, TestRandomAccess) {
+    std::vector<std::vector<int>> vs = sampleChain(50, 300, 2);
+
+    std::istringstream iss(encodeChain(vs, 16), std::ios::binary);
+    ChainReader reader(iss);
+
+    EXPECT_EQ(reader.k(), 50);
+    EXPECT_EQ(reader.size(), vs.size());
+
+    for (std::size_t i : {299, 0, 15, 16, 17, 150}) {
+        EXPECT_EQ(reader.get(i), vs[i]);
+    }
+
+    // Sequential decoding resumes after the last accessed sample
+    std::vector<int> v;
+    ASSERT_TRUE(reader.next(v));
+    EXPECT_EQ(v, vs[151]);
+
+    EXPECT_THROW(reader.get(vs.size()), std::out_of_range);
+}
+
+TEST(ChainTest, TestCompression) {
+    std::vector<std::vector<int>> vs = sampleChain(500, 1000, 3);
+
+    std::ostringstream text;
+    for (const auto& v : vs) {
+        for (int val : v) {
+            text << val << " ";
+        }
+        text << "\n";
+    }
+
+    EXPECT_LT(encodeChain(vs).size() * 10, text.str().size());
+}
+
+TEST(ChainTest, TestInvalidChains) {
+    std::ostringstream oss;
+    ChainWriter writer(oss, 3);
+    EXPECT_THROW(writer.write({0, 1}), std::invalid_argument);
+    EXPECT_THROW(writer.write({0, 1, 5}), std::out_of_range);
+
+    std::istringstream iss("P2VX");
+    EXPECT_THROW(ChainReader reader(iss), std::runtime_error);
+
+    EXPECT_THROW(ChainWriter(oss, CHAIN_MAX_K + 1), std::invalid_argument);
+    EXPECT_THROW(ChainWriter(oss, -1), std::invalid_argument);
+
+    // Header (k = 2, keyframe_interval = 2), a keyframe at byte 7, and a footer at byte 10
+    // with the number of samples, the keyframe offsets and the footer offset
+    auto makeChain = [](std::uint8_t keyframe_interval, const std::string &footer) {
+        std::string bytes = std::string("P2VC\x01\x02", 6) + static_cast<char>(keyframe_interval) +
+                            std::string("\x00\x00\x01\x02", 4) + footer;
+        bytes += std::string("\x0a\x00\x00\x00\x00\x00\x00\x00", 8);
+        return bytes;
+    };
+
+    std::istringstream valid(makeChain(2, std::string("\x01\x01\x07", 3)));
+    ChainReader reader(valid);
+    EXPECT_EQ(reader.get(0), std::vector<int>({0, 1}));
+
+    std::istringstream zero_interval(makeChain(0, std::string("\x01\x01\x07", 3)));
+    EXPECT_THROW(ChainReader reader(zero_interval), std::runtime_error);
+
+    std::istringstream huge_k(std::string("P2VC\x01\xff\xff\xff\xff\x0f\x02", 11));
+    EXPECT_THROW(ChainReader reader(huge_k), std::runtime_error);
+
+    std::istringstream too_many_keyframes(makeChain(2, std::string("\x01\x02\x07\x07", 4)));
+    ChainReader reader_too_many(too_many_keyframes);
+    EXPECT_THROW(reader_too_many.size(), std::runtime_error);
+
+    std::istringstream huge_count(makeChain(2, std::string("\x01\xff\xff\xff\xff\x0f", 6)));
+    ChainReader reader_huge_count(huge_count);
+    EXPECT_THROW(reader_huge_count.size(), std::runtime_error);
+
+    std::istringstream bad_offset(makeChain(2, std::string("\x01\x01\x30", 3)));
+    ChainReader reader_bad_offset(bad_offset);
+    EXPECT_THROW(reader_bad_offset.get(0), std::runtime_error);
+
+    // Corrupt records after the header (k = 2): v[1] = 5 in a keyframe, v[1] = 7 in a delta,
+    // and a delta index gap of 2^64 - 1
+    std::vector<int> v;
+    std::istringstream bad_keyframe(std::string("P2VC\x01\x02\x02\x00\x00\x05", 10));
+    ChainReader reader_bad_keyframe(bad_keyframe);
+    EXPECT_THROW(reader_bad_keyframe.next(v), std::runtime_error);
+
+    std::istringstream bad_delta(std::string("P2VC\x01\x02\x02\x00\x00\x01\x01\x01\x01\x07", 14));
+    ChainReader reader_bad_delta(bad_delta);
+    ASSERT_TRUE(reader_bad_delta.next(v));
+    EXPECT_THROW(reader_bad_delta.next(v), std::runtime_error);
+
+    std::istringstream bad_gap(
+        std::string("P2VC\x01\x02\x02\x00\x00\x01\x01\x01", 12) + std::string(9, '\xff') +
+        std::string("\x01\x00", 2));
+    ChainReader reader_bad_gap(bad_gap);
+    ASSERT_TRUE(reader_bad_gap.next(v));
+    EXPECT_THROW(reader_bad_gap.next(v), std::runtime_error);
+}
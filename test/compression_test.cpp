@@ -0,0 +1,153 @@
+#include "../src/compression.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "../src/chain.hpp"
+#include "../src/phylo2vec.hpp"
+
+/**
+ * @brief Text spanning several chunks of DecompressingStreambuf
+ */
+std::string makeText() {
+    std::ostringstream oss;
+    for (int i = 0; i < 30000; ++i) {
+        for (int val : sample(30)) {
+            oss << val << " ";
+        }
+        oss << "\n";
+    }
+    return oss.str();
+}
+
+std::string readAll(std::istream& in) {
+    std::ostringstream oss;
+    oss << in.rdbuf();
+    return oss.str();
+}
+
+void checkRoundTrip(const std::string& path, Compression compression) {
+    const std::string text = makeText();
+    {
+        CompressedOfstream out(path);
+        out << text;
+    }
+
+    CompressedIfstream in(path);
+    EXPECT_EQ(in.compression(), compression);
+
+    // Line by line, as done by the CLI
+    std::string line;
+    std::size_t num_lines = 0;
+    while (std::getline(in, line)) {
+        ++num_lines;
+    }
+    EXPECT_EQ(num_lines, 30000);
+
+    CompressedIfstream in2(path);
+    EXPECT_EQ(readAll(in2), text);
+
+    std::remove(path.c_str());
+}
+
+TEST(CompressionTest, TestPlainRoundTrip) { checkRoundTrip("compression_test.txt", Compression::NONE); }
+
+#ifdef PHYLO2VEC_WITH_ZLIB
+TEST(CompressionTest, TestGzipRoundTrip) {
+    checkRoundTrip("compression_test.txt.gz", Compression::GZIP);
+}
+
+TEST(CompressionTest, TestConcatenatedGzip) {
+    const std::string path1 = "compression_test_1.gz", path2 = "compression_test_2.gz";
+    {
+        CompressedOfstream out1(path1), out2(path2);
+        out1 << "first\n";
+        out2 << "second\n";
+    }
+
+    // cat 1.gz 2.gz > 1.gz
+    {
+        std::ifstream in2(path2, std::ios::binary);
+        std::ofstream out1(path1, std::ios::binary | std::ios::app);
+        out1 << in2.rdbuf();
+    }
+
+    CompressedIfstream in(path1);
+    EXPECT_EQ(readAll(in), "first\nsecond\n");
+
+    std::remove(path1.c_str());
+    std::remove(path2.c_str());
+}
+
+TEST(CompressionTest, TestTruncatedGzip) {
+    const std::string path = "compression_test_truncated.gz";
+    {
+        CompressedOfstream out(path);
+        out << makeText();
+    }
+
+    // Keep only the first half
+    std::string data;
+    {
+        std::ifstream in(path, std::ios::binary);
+        data = readAll(in);
+    }
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), data.size() / 2);
+    }
+
+    // Errors of the decompression thread are rethrown by the stream
+    CompressedIfstream in(path);
+    std::string line;
+    EXPECT_THROW(
+        {
+            while (std::getline(in, line)) {
+            }
+        },
+        std::runtime_error);
+
+    std::remove(path.c_str());
+}
+
+TEST(CompressionTest, TestCompressedChain) {
+    const std::string path = "compression_test_chain.p2vc.gz";
+
+    std::vector<std::vector<int>> vs;
+    {
+        CompressedOfstream out(path);
+        ChainWriter writer(out, 40, 8);
+        for (int i = 0; i < 100; ++i) {
+            vs.push_back(sample(40));
+            writer.write(vs.back());
+        }
+        writer.close();
+    }
+
+    // Sequential decoding does not need a seekable stream
+    CompressedIfstream in(path);
+    ChainReader reader(in);
+
+    std::vector<std::vector<int>> decoded;
+    std::vector<int> v;
+    while (reader.next(v)) {
+        decoded.push_back(v);
+    }
+    EXPECT_EQ(decoded, vs);
+
+    std::remove(path.c_str());
+}
+#endif  // PHYLO2VEC_WITH_ZLIB
+
+#ifdef PHYLO2VEC_WITH_ZSTD
+TEST(CompressionTest, TestZstdRoundTrip) {
+    checkRoundTrip("compression_test.txt.zst", Compression::ZSTD);
+}
+#endif  // PHYLO2VEC_WITH_ZSTD
+
+TEST(CompressionTest, TestMissingFile) {
+    EXPECT_THROW(CompressedIfstream in("compression_test_missing.txt"), std::runtime_error);
+}
@@ -0,0 +1,110 @@
+#include "../src/distances.hpp"
+
+#include <gtest/gtest.h>
+
+#include <regex>
+
+#include "../src/phylo2vec.hpp"
+
+TEST(CopheneticDistancesTest, TestSmallTree) {
+    // (((2,1)4,0)5,3)6;
+    std::vector<int> distances = getCopheneticDistances(std::vector<int>({0, 1, 4}));
+
+    // clang-format off
+    std::vector<int> expected = {
+        0, 3, 3, 3,
+        3, 0, 2, 4,
+        3, 2, 0, 4,
+        3, 4, 4, 0
+    };
+    // clang-format on
+
+    EXPECT_EQ(distances, expected);
+
+    EXPECT_EQ(getCopheneticDistances(std::vector<int>({0, 1, 4}), true),
+              std::vector<int>({3, 3, 3, 2, 4, 4}));
+}
+
+TEST(CopheneticDistancesTest, TestInvalidVectors) {
+    EXPECT_THROW(getCopheneticDistances(std::vector<int>({0, 5, 1})), std::out_of_range);
+    EXPECT_THROW(getCopheneticDistances(std::vector<std::vector<int>>({{3}})), std::out_of_range);
+}
+
+TEST(CopheneticDistancesTest, TestBranchLengths) {
+    std::vector<double> branch_lengths;
+    std::vector<std::array<int, 3>> M =
+        getAncestryFromNewick("(((2:1,1:2)4:0.5,0:1)5:0,3:1)6;", branch_lengths);
+
+    std::vector<double> distances = getCopheneticDistances(M, branch_lengths, true);
+
+    std::vector<double> expected = {3.5, 2.5, 2, 3, 3.5, 2.5};
+    ASSERT_EQ(distances.size(), expected.size());
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_DOUBLE_EQ(distances[i], expected[i]);
+    }
+}
+
+TEST(CopheneticDistancesTest, TestLCA) {
+    for (int k = 1; k < 50; ++k) {
+        std::vector<std::array<int, 3>> M = getAncestry(sample(k));
+
+        std::vector<int> parents(2 * k + 1, -1);
+        for (const auto& row : M) {
+            parents[row[1]] = parents[row[2]] = row[0];
+        }
+
+        LCAIndex index = buildLCAIndex(M);
+
+        for (int u = 0; u <= 2 * k; ++u) {
+            for (int v = 0; v <= 2 * k; ++v) {
+                // Naive LCA: first ancestor of v that is also an ancestor of u
+                std::vector<bool> is_ancestor(2 * k + 1, false);
+                for (int node = u; node != -1; node = parents[node]) {
+                    is_ancestor[node] = true;
+                }
+                int lca = v;
+                while (!is_ancestor[lca]) {
+                    lca = parents[lca];
+                }
+
+                EXPECT_EQ(getLCA(index, u, v), lca);
+            }
+        }
+    }
+}
+
+TEST(CopheneticDistancesTest, TestBatch) {
+    std::vector<std::vector<int>> vs;
+    std::vector<std::string> newicks;
+    for (int k = 1; k < 150; k += 7) {
+        vs.push_back(sample(k));
+        // Unit branch lengths: patristic distances should be topological distances
+        newicks.push_back(std::regex_replace(toNewick(vs.back()), std::regex("(\\d+)([,)])"),
+                                             "$1:1$2"));
+    }
+
+    std::vector<std::vector<int>> full = getCopheneticDistances(vs);
+    std::vector<std::vector<int>> condensed = getCopheneticDistances(vs, true);
+
+    std::vector<std::vector<double>> from_newicks = getCopheneticDistances(newicks);
+
+    for (std::size_t t = 0; t < vs.size(); ++t) {
+        const std::size_t n = vs[t].size() + 1;
+
+        ASSERT_EQ(full[t].size(), n * n);
+        ASSERT_EQ(condensed[t].size(), n * (n - 1) / 2);
+        ASSERT_EQ(from_newicks[t].size(), n * n);
+
+        std::size_t idx = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            EXPECT_EQ(full[t][i * n + i], 0);
+            for (std::size_t j = i + 1; j < n; ++j) {
+                EXPECT_EQ(full[t][i * n + j], full[t][j * n + i]);
+                EXPECT_EQ(full[t][i * n + j], condensed[t][idx++]);
+            }
+        }
+
+        std::vector<double> expected(full[t].begin(), full[t].end());
+        EXPECT_EQ(from_newicks[t], expected);
+    }
+}
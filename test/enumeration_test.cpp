@@ -0,0 +1,169 @@
+#include "../src/enumeration.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <set>
+
+#include "../src/phylo2vec.hpp"
+
+TEST(EnumerationTest, TestNumTrees) {
+    EXPECT_EQ(getNumTrees(0), 1u);
+    EXPECT_EQ(getNumTrees(1), 1u);
+    EXPECT_EQ(getNumTrees(2), 3u);
+    EXPECT_EQ(getNumTrees(3), 15u);
+    EXPECT_EQ(getNumTrees(4), 105u);
+    EXPECT_EQ(toString(getNumTrees(10)), "654729075");
+
+    EXPECT_NO_THROW(getNumTrees(28));
+    EXPECT_THROW(getNumTrees(29), std::overflow_error);
+}
+
+TEST(EnumerationTest, TestRankUnrank) {
+    EXPECT_EQ(rank(std::vector<int>({0, 0, 0})), 0u);
+    EXPECT_EQ(rank(std::vector<int>({0, 2, 4})), 14u);
+    EXPECT_EQ(unrank(14, 3), std::vector<int>({0, 2, 4}));
+    EXPECT_THROW(unrank(15, 3), std::out_of_range);
+
+    for (int k = 1; k <= 28; ++k) {
+        for (int i = 0; i < 20; ++i) {
+            const std::vector<int> v = sample(k);
+            const uint128 r = rank(v);
+            EXPECT_LT(r, getNumTrees(k));
+            EXPECT_EQ(unrank(r, k), v);
+            EXPECT_EQ(rankToString(v), toString(r));
+        }
+    }
+}
+
+TEST(EnumerationTest, TestRankUnrankString) {
+    EXPECT_EQ(rankToString(std::vector<int>()), "0");
+    EXPECT_EQ(unrankFromString("14", 3), std::vector<int>({0, 2, 4}));
+    EXPECT_THROW(unrankFromString("15", 3), std::out_of_range);
+    EXPECT_THROW(unrankFromString("1x", 3), std::invalid_argument);
+
+    for (int k : {50, 200, 1000}) {
+        for (int i = 0; i < 10; ++i) {
+            const std::vector<int> v = sample(k);
+            EXPECT_EQ(unrankFromString(rankToString(v), k), v);
+        }
+    }
+
+    // Largest rank
+    std::vector<int> v_max(40);
+    for (int i = 0; i < 40; ++i) {
+        v_max[i] = 2 * i;
+    }
+    const std::string r_max = rankToString(v_max);
+    EXPECT_EQ(unrankFromString(r_max, 40), v_max);
+    std::string r_next = r_max;
+    ++r_next.back();  // 79!! - 1 is even: no carry
+    EXPECT_THROW(unrankFromString(r_next, 40), std::out_of_range);
+}
+
+TEST(EnumerationTest, TestEnumerateAll) {
+    // Single leaf
+    TreeEnumerator single(0);
+    EXPECT_TRUE(single.next());
+    EXPECT_TRUE(single.v().empty());
+    EXPECT_TRUE(single.ancestry().empty());
+    EXPECT_FALSE(single.next());
+
+    for (int k = 1; k <= 6; ++k) {
+        TreeEnumerator enumerator(k);
+        uint128 count = 0;
+        std::vector<int> previous;
+        std::set<std::string> newicks;
+        while (enumerator.next()) {
+            const std::vector<int> &v = enumerator.v();
+            ASSERT_EQ(enumerator.rank(), count);
+            ASSERT_EQ(rank(v), count);
+            if (count > 0) {
+                ASSERT_TRUE(std::lexicographical_compare(previous.begin(), previous.end(),
+                                                         v.begin(), v.end()));
+            }
+            ASSERT_EQ(enumerator.ancestry(), getAncestry(v));
+            newicks.insert(toNewick(v));
+
+            previous = v;
+            ++count;
+        }
+        EXPECT_EQ(count, getNumTrees(k));
+        // Each tree is distinct
+        EXPECT_EQ(newicks.size(), static_cast<std::size_t>(getNumTrees(k)));
+        EXPECT_FALSE(enumerator.next());
+    }
+}
+
+TEST(EnumerationTest, TestEnumerateRange) {
+    const int k = 5;
+    TreeEnumerator enumerator(k, 100, 200);
+    uint128 r = 100;
+    while (enumerator.next()) {
+        EXPECT_EQ(enumerator.v(), unrank(r, k));
+        ++r;
+    }
+    EXPECT_EQ(r, 200u);
+
+    TreeEnumerator empty(k, 50, 50);
+    EXPECT_FALSE(empty.next());
+
+    // end is clamped to the number of trees
+    TreeEnumerator last(k, getNumTrees(k) - 1, getNumTrees(k) + 10);
+    EXPECT_TRUE(last.next());
+    EXPECT_EQ(last.v(), std::vector<int>({0, 2, 4, 6, 8}));
+    EXPECT_FALSE(last.next());
+}
+
+TEST(EnumerationTest, TestSplitRanks) {
+    for (int num_parts : {1, 2, 7, 200}) {
+        const auto ranges = splitRanks(5, num_parts);
+        ASSERT_EQ(ranges.size(), static_cast<std::size_t>(num_parts));
+        EXPECT_EQ(ranges.front().first, 0u);
+        EXPECT_EQ(ranges.back().second, getNumTrees(5));
+        for (int i = 1; i < num_parts; ++i) {
+            EXPECT_EQ(ranges[i].first, ranges[i - 1].second);
+            const uint128 size_i = ranges[i].second - ranges[i].first;
+            const uint128 size_0 = ranges[0].second - ranges[0].first;
+            EXPECT_LE(size_0 - size_i, 1u);
+        }
+    }
+    EXPECT_THROW(splitRanks(5, 0), std::invalid_argument);
+}
+
+TEST(EnumerationTest, TestEnumerateTreesParallel) {
+    const int k = 6;
+    const int num_parts = 8;
+    std::vector<uint128> counts(num_parts, 0);
+    std::vector<int> cherries(num_parts, 0);
+
+    enumerateTrees(k, num_parts, [&](int part, const TreeEnumerator &enumerator) {
+        ++counts[part];
+        for (const auto &row : enumerator.ancestry()) {
+            if (row[1] <= k && row[2] <= k) {
+                ++cherries[part];
+            }
+        }
+    });
+
+    uint128 total = 0;
+    for (uint128 count : counts) {
+        total += count;
+    }
+    EXPECT_EQ(total, getNumTrees(k));
+
+    int total_cherries = 0;
+    for (int c : cherries) {
+        total_cherries += c;
+    }
+    int expected_cherries = 0;
+    TreeEnumerator enumerator(k);
+    while (enumerator.next()) {
+        for (const auto &row : getAncestry(enumerator.v())) {
+            if (row[1] <= k && row[2] <= k) {
+                ++expected_cherries;
+            }
+        }
+    }
+    EXPECT_EQ(total_cherries, expected_cherries);
+}
@@ -0,0 +1,91 @@
+#include "../src/nexus.hpp"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "../src/phylo2vec.hpp"
+
+const char MRBAYES_NEXUS[] = R"(#NEXUS
+[ID: 1234; a comment with a semicolon]
+begin taxa;
+    dimensions ntax=4;
+end;
+begin trees;
+    translate
+        1 Homo_sapiens,
+        2 'Pan troglodytes',
+        3 Gorilla,
+        4 'O''Pongo'
+        ;
+    tree STATE_0 = [&R] ((1:0.1,2[&rate=1.0]:0.2):0.3,(3:0.4,4:0.5):0.6);
+    tree STATE_10 = [&R] [&lnP=-1234.5] (((1:0.1,
+        3:0.2)5:0.3,2:0.1),4:1.0);
+end;
+)";
+
+TEST(NexusTest, TestTranslateBlock) {
+    std::istringstream iss(MRBAYES_NEXUS);
+    NexusReader reader(iss);
+
+    NexusTree tree;
+
+    ASSERT_TRUE(reader.next(tree));
+    EXPECT_EQ(tree.name, "STATE_0");
+    EXPECT_EQ(tree.newick, "((0:0.1,1:0.2):0.3,(2:0.4,3:0.5):0.6);");
+    EXPECT_EQ(toNewick(fromNewick(tree.newick)), "((3,2)4,(1,0)5)6;");
+
+    EXPECT_EQ(reader.taxa(), std::vector<std::string>(
+                                 {"Homo_sapiens", "Pan troglodytes", "Gorilla", "O'Pongo"}));
+
+    ASSERT_TRUE(reader.next(tree));
+    EXPECT_EQ(tree.name, "STATE_10");
+    EXPECT_EQ(tree.newick, "(((0:0.1,2:0.2):0.3,1:0.1),3:1.0);");
+    EXPECT_EQ(toNewick(fromNewick(tree.newick)), "(((2,0)4,1)5,3)6;");
+
+    EXPECT_FALSE(reader.next(tree));
+}
+
+TEST(NexusTest, TestTaxonNamesInTrees) {
+    std::istringstream iss(
+        "#NEXUS\nBEGIN TREES;\n"
+        "TREE t1 = ((A,B),C);\n"
+        "TREE t2 = ((C,B),A);\n"
+        "END;\n");
+    NexusReader reader(iss);
+
+    NexusTree tree;
+
+    ASSERT_TRUE(reader.next(tree));
+    EXPECT_EQ(tree.newick, "((0,1),2);");
+    EXPECT_EQ(reader.taxa(), std::vector<std::string>({"A", "B", "C"}));
+
+    ASSERT_TRUE(reader.next(tree));
+    EXPECT_EQ(tree.newick, "((2,1),0);");
+
+    EXPECT_FALSE(reader.next(tree));
+}
+
+TEST(NexusTest, TestIntegerTaxonNames) {
+    // Taxa defined by a TAXA block, with integer names that differ from their tokens
+    std::istringstream iss(
+        "#NEXUS\nbegin taxa;\ntaxlabels 1 2 3;\nend;\n"
+        "begin trees;\ntranslate 1 2, 2 1, 3 3;\ntree t = ((1,3),2);\nend;\n");
+    NexusReader reader(iss);
+
+    NexusTree tree;
+    ASSERT_TRUE(reader.next(tree));
+    EXPECT_EQ(tree.newick, "((1,2),0);");
+    EXPECT_EQ(reader.taxa(), std::vector<std::string>({"1", "2", "3"}));
+}
+
+TEST(NexusTest, TestInvalidFiles) {
+    std::istringstream not_nexus("((0,1),2);");
+    EXPECT_THROW(NexusReader reader(not_nexus), std::runtime_error);
+
+    std::istringstream unknown_taxon(
+        "#NEXUS\nbegin trees;\ntranslate 1 A, 2 B, 3 C;\ntree t = ((1,2),4);\nend;");
+    NexusReader reader(unknown_taxon);
+    NexusTree tree;
+    EXPECT_THROW(reader.next(tree), std::runtime_error);
+}
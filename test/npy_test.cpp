@@ -0,0 +1,136 @@
+#include "../src/npy.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+
+#include "../src/phylo2vec.hpp"
+
+TEST(NpyTest, TestVectorsRoundTrip) {
+    const std::string path = "npy_test_vectors.npy";
+
+    // Large enough to be written in several chunks
+    const int k = 100;
+    std::vector<std::vector<int>> vs;
+    for (int i = 0; i < 5000; ++i) {
+        vs.push_back(sample(k));
+    }
+
+    for (NpyDtype dtype : {NpyDtype::INT16, NpyDtype::INT32}) {
+        writeNpy(path, vs, dtype);
+
+        MappedNpy npy(path);
+
+        EXPECT_EQ(npy.shape(), std::vector<std::size_t>({vs.size(), k}));
+        EXPECT_EQ(npy.dtype(), dtype);
+
+        for (std::size_t i = 0; i < vs.size(); ++i) {
+            EXPECT_EQ(npy.getRow(i), vs[i]);
+        }
+    }
+
+    // Zero-copy access
+    MappedNpy npy(path);
+    const std::int32_t* data = npy.data<std::int32_t>();
+    EXPECT_EQ(data[3 * k + 7], vs[3][7]);
+    EXPECT_THROW(npy.data<std::int16_t>(), std::invalid_argument);
+
+    std::remove(path.c_str());
+}
+
+TEST(NpyTest, TestAncestryRoundTrip) {
+    const std::string path = "npy_test_ancestry.npy";
+
+    const int k = 20;
+    std::vector<std::vector<std::array<int, 3>>> ancestries;
+    {
+        NpyWriter writer(path, {k, 3});
+        for (int i = 0; i < 10; ++i) {
+            ancestries.push_back(getAncestry(sample(k)));
+            writer.write(ancestries.back());
+        }
+        EXPECT_EQ(writer.num_rows(), 10);
+    }
+
+    MappedNpy npy(path);
+    EXPECT_EQ(npy.shape(), std::vector<std::size_t>({10, k, 3}));
+
+    for (std::size_t i = 0; i < ancestries.size(); ++i) {
+        std::vector<int> row = npy.getRow(i);
+        for (int j = 0; j < k; ++j) {
+            for (int c = 0; c < 3; ++c) {
+                EXPECT_EQ(row[3 * j + c], ancestries[i][j][c]);
+            }
+        }
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST(NpyTest, TestRawRoundTrip) {
+    const std::string path = "npy_test_raw.bin";
+
+    const int k = 30;
+    std::vector<std::vector<int>> vs;
+    {
+        NpyWriter writer(path, {k}, NpyDtype::INT16, true);
+        for (int i = 0; i < 100; ++i) {
+            vs.push_back(sample(k));
+            writer.write(vs.back());
+        }
+        EXPECT_THROW(writer.write(sample(k + 1)), std::invalid_argument);
+    }
+
+    MappedNpy raw(path, {k}, NpyDtype::INT16);
+    EXPECT_EQ(raw.num_rows(), vs.size());
+    for (std::size_t i = 0; i < vs.size(); ++i) {
+        EXPECT_EQ(raw.getRow(i), vs[i]);
+    }
+
+    // A raw file is not a .npy file
+    EXPECT_THROW(MappedNpy npy(path), std::runtime_error);
+
+    std::remove(path.c_str());
+}
+
+TEST(NpyTest, TestInvalidHeaders) {
+    const std::string path = "npy_test_invalid.npy";
+
+    auto writeNpy = [&path](char major, const std::string &dict, std::size_t data_size) {
+        std::ofstream file(path, std::ios::binary);
+        file << "\x93NUMPY" << major << '\0' << static_cast<char>(dict.size() & 0xff)
+             << static_cast<char>(dict.size() >> 8) << dict << std::string(data_size, '\0');
+    };
+
+    writeNpy('\x01', "{'descr': '<i4', 'fortran_order': False, 'shape': (2, 3), }\n", 24);
+    {
+        MappedNpy npy(path);
+        EXPECT_EQ(npy.shape(), std::vector<std::size_t>({2, 3}));
+    }
+
+    // Missing or invalid shape
+    writeNpy('\x01', "{'descr': '<i4', 'fortran_order': False, }\n", 24);
+    EXPECT_THROW(MappedNpy npy(path), std::runtime_error);
+    writeNpy('\x01', "{'descr': '<i4', 'fortran_order': False, 'shape': (2, x), }\n", 24);
+    EXPECT_THROW(MappedNpy npy(path), std::runtime_error);
+
+    // 2^62 * 4 * 4 bytes wraps around to 0
+    writeNpy('\x01',
+             "{'descr': '<i4', 'fortran_order': False, 'shape': (4611686018427387904, 4), }\n",
+             24);
+    EXPECT_THROW(MappedNpy npy(path), std::runtime_error);
+
+    // Truncated data
+    writeNpy('\x01', "{'descr': '<i4', 'fortran_order': False, 'shape': (2, 3), }\n", 20);
+    EXPECT_THROW(MappedNpy npy(path), std::runtime_error);
+
+    // Version 2.0 header length (4 bytes) past the end of the file
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "\x93NUMPY\x02" << '\0' << "\x10\x00";
+    }
+    EXPECT_THROW(MappedNpy npy(path), std::runtime_error);
+
+    std::remove(path.c_str());
+}
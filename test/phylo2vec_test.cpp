@@ -2,8 +2,11 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <numeric>
+#include <random>
 #include <regex>
 #include <unordered_map>
 
@@ -93,6 +96,158 @@ TEST_P(Phylo2VecTest, TestGetNumLeavesFromNewick) {
     EXPECT_EQ(getNumLeavesFromNewick(nw), k + 1);
 }
 
+TEST_P(Phylo2VecTest, TestAncestryBacktoV) {
+    int k = GetParam();
+
+    std::vector<int> v = sample(k);
+
+    std::vector<std::array<int, 3>> M = getAncestry(v);
+
+    EXPECT_EQ(fromAncestry(M), v);
+
+    // The order of the internal node labels should not matter
+    std::vector<int> internal_labels(k);
+    std::iota(internal_labels.begin(), internal_labels.end(), k + 1);
+    std::shuffle(internal_labels.begin(), internal_labels.end(), std::mt19937(k));
+
+    for (auto& row : M) {
+        for (int& node : row) {
+            if (node > k) {
+                node = internal_labels[node - k - 1];
+            }
+        }
+    }
+
+    EXPECT_EQ(fromAncestry(M), v);
+}
+
+TEST_P(Phylo2VecTest, TestAncestryFromPairs) {
+    int k = GetParam();
+
+    std::vector<int> v = sample(k);
+
+    std::vector<std::pair<int, int>> pairs;
+    for (int j = 0; j < k; ++j) {
+        addPair(pairs, j, v[j]);
+    }
+
+    EXPECT_EQ(getPairs(v), pairs);
+    EXPECT_EQ(getAncestryFromPairs(pairs), getAncestry(v));
+}
+
+TEST_P(Phylo2VecTest, TestParseNewickBacktoV) {
+    int k = GetParam();
+
+    std::vector<int> v = sample(k);
+
+    std::vector<double> branch_lengths;
+    std::vector<std::array<int, 3>> M = getAncestryFromNewick(toNewick(v), branch_lengths);
+
+    EXPECT_EQ(fromAncestry(M), v);
+    EXPECT_EQ(branch_lengths, std::vector<double>(2 * k + 1, 0.0));
+}
+
+TEST_P(Phylo2VecTest, TestInducedSubtreeOfFirstLeaves) {
+    int k = GetParam();
+
+    std::vector<int> v = sample(k);
+
+    // Keeping leaves 0..m-1 should give the first m - 1 entries of v
+    int num_kept = 2 + k / 2;
+    std::vector<bool> keep(k + 1, false);
+    std::fill(keep.begin(), keep.begin() + num_kept, true);
+
+    std::vector<int> expected(v.begin(), v.begin() + num_kept - 1);
+
+    EXPECT_EQ(getInducedSubtree(v, keep), expected);
+
+    // Keeping all leaves should not change v
+    EXPECT_EQ(getInducedSubtree(v, std::vector<bool>(k + 1, true)), v);
+}
+
+TEST(InducedSubtreeTest, TestSmallTree) {
+    // (((2,1)4,0)5,3)6;
+    std::vector<int> v = {0, 1, 4};
+
+    // Drop leaf 0: ((1,0),2) after relabelling
+    EXPECT_EQ(getInducedSubtree(v, {false, true, true, true}), std::vector<int>({0, 2}));
+
+    // Drop leaf 1: ((1,0),2) after relabelling
+    EXPECT_EQ(getInducedSubtree(v, {true, false, true, true}), std::vector<int>({0, 2}));
+
+    // Drop leaf 3: ((2,1),0)
+    EXPECT_EQ(getInducedSubtree(v, {true, true, true, false}), std::vector<int>({0, 1}));
+
+    EXPECT_THROW(getInducedSubtree(v, {true, false, false, false}), std::invalid_argument);
+    EXPECT_THROW(getInducedSubtree(v, {true, true, true}), std::invalid_argument);
+}
+
+TEST(ParseNewickTest, TestFromNewick) {
+    std::ifstream file("../test/100trees.txt");
+
+    std::string stringNewick;
+    std::regex pattern("tip_");
+    while (std::getline(file, stringNewick)) {
+        std::string intNewick = std::regex_replace(stringNewick, pattern, "");
+
+        std::vector<int> v = fromNewick(intNewick);
+
+        std::vector<int> expected = newick2v(intNewick).v;
+        expected.erase(expected.begin());
+
+        EXPECT_EQ(v, expected);
+    }
+}
+
+TEST(ParseNewickTest, TestInvalidNewicks) {
+    std::vector<double> branch_lengths;
+
+    // Non-binary
+    EXPECT_THROW(getAncestryFromNewick("(0,1,2);", branch_lengths), std::invalid_argument);
+    // Taxa
+    EXPECT_THROW(getAncestryFromNewick("(a,b);", branch_lengths), std::invalid_argument);
+    // Unbalanced
+    EXPECT_THROW(getAncestryFromNewick("((0,1),2;", branch_lengths), std::invalid_argument);
+    // Missing leaf
+    EXPECT_THROW(getAncestryFromNewick("((0,3),2);", branch_lengths), std::invalid_argument);
+}
+
+TEST(AncestryTest, TestInvalidVectors) {
+    // v[i] > 2i, and negative values
+    for (const std::vector<int> &v : std::vector<std::vector<int>>({{0, 5, 1}, {3}, {0, -1}})) {
+        EXPECT_THROW(getPairs(v), std::out_of_range);
+        EXPECT_THROW(getAncestry(v), std::out_of_range);
+        EXPECT_THROW(toNewick(v), std::out_of_range);
+        EXPECT_THROW(getInducedSubtree(v, std::vector<bool>(v.size() + 1, true)),
+                     std::out_of_range);
+    }
+
+    std::vector<std::pair<int, int>> pairs = getPairs({0, 1});
+    EXPECT_THROW(addPair(pairs, 2, 5), std::out_of_range);
+    EXPECT_THROW(addPair(pairs, 3, 0), std::out_of_range);
+}
+
+TEST(InducedSubtreeTest, TestBatch) {
+    const int k = 30;
+
+    std::vector<std::vector<int>> vs;
+    for (int i = 0; i < 50; ++i) {
+        vs.push_back(sample(k));
+    }
+
+    std::vector<bool> keep(k + 1, true);
+    keep[0] = keep[7] = keep[k] = false;
+
+    std::vector<std::vector<int>> induced_vs = getInducedSubtrees(vs, keep);
+
+    ASSERT_EQ(induced_vs.size(), vs.size());
+    for (std::size_t i = 0; i < vs.size(); ++i) {
+        EXPECT_EQ(induced_vs[i], getInducedSubtree(vs[i], keep));
+        EXPECT_EQ(induced_vs[i].size(), k - 3);
+        EXPECT_NO_THROW(check_v(induced_vs[i]));
+    }
+}
+
 TEST(StringNewickTest, TestStringNewickToV) {
     std::ifstream file("../test/100trees.txt");
 
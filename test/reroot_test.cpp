@@ -0,0 +1,123 @@
+#include "../src/reroot.hpp"
+
+#include <gtest/gtest.h>
+
+#include "../src/phylo2vec.hpp"
+
+namespace {
+
+std::vector<int> rerootV(const std::string &newick, RerootMethod method, int outgroup = -1) {
+    std::vector<double> branch_lengths;
+    return fromAncestry(reroot(parseUnrootedNewick(newick), method, outgroup, branch_lengths));
+}
+
+}  // namespace
+
+TEST(RerootTest, TestParse) {
+    UnrootedTree tree = parseUnrootedNewick("(0:1,1:2,(2,3)5:0.5)6;");
+    EXPECT_EQ(tree.num_leaves, 4);
+    EXPECT_EQ(tree.neighbors.size(), 6u);
+    EXPECT_EQ(tree.neighbors[tree.root].size(), 3u);
+    ASSERT_EQ(tree.neighbors[1].size(), 1u);
+    EXPECT_EQ(tree.neighbors[1][0].first, tree.root);
+    EXPECT_DOUBLE_EQ(tree.neighbors[1][0].second, 2.0);
+
+    std::vector<std::string> taxa;
+    tree = parseUnrootedNewick("('a',b,(c d,[comment]e));", &taxa);
+    EXPECT_EQ(taxa, std::vector<std::string>({"'a'", "b", "c d", "e"}));
+
+    EXPECT_THROW(parseUnrootedNewick("(0,1,(2,3);"), std::invalid_argument);
+    EXPECT_THROW(parseUnrootedNewick("(0,1,a);"), std::invalid_argument);
+    EXPECT_THROW(parseUnrootedNewick("(0,1,3);"), std::invalid_argument);
+    EXPECT_THROW(parseUnrootedNewick("(a,b,a);", &taxa), std::invalid_argument);
+}
+
+TEST(RerootTest, TestRootedInput) {
+    for (int k = 1; k < 100; ++k) {
+        std::vector<int> v = sample(k);
+        std::string newick = toNewick(v);
+
+        EXPECT_EQ(rerootV(newick, RerootMethod::NONE), v);
+        EXPECT_EQ(rerootV(newick, RerootMethod::RESOLVE), v);
+    }
+}
+
+TEST(RerootTest, TestResolve) {
+    EXPECT_EQ(rerootV("(0,1,(2,3));", RerootMethod::RESOLVE), fromNewick("((0,1),(2,3));"));
+    EXPECT_EQ(rerootV("((0,1),2,3);", RerootMethod::RESOLVE), fromNewick("(((0,1),2),3);"));
+
+    EXPECT_THROW(rerootV("(0,1,(2,3));", RerootMethod::NONE), std::invalid_argument);
+    EXPECT_THROW(rerootV("(0,1,2,3);", RerootMethod::RESOLVE), std::invalid_argument);
+
+    EXPECT_EQ(fromNewick("(0,1,(2,3));", RerootMethod::RESOLVE), fromNewick("((0,1),(2,3));"));
+}
+
+TEST(RerootTest, TestLeaf) {
+    EXPECT_EQ(rerootV("(((0,1),2),3);", RerootMethod::LEAF, 0), fromNewick("(0,(1,(2,3)));"));
+    EXPECT_EQ(rerootV("(0,1,(2,3));", RerootMethod::LEAF, 3), fromNewick("(3,(2,(0,1)));"));
+
+    // The result does not depend on the original root
+    for (int k = 2; k < 100; ++k) {
+        std::vector<int> v = sample(k);
+        std::vector<int> rooted_at_k = rerootV(toNewick(v), RerootMethod::LEAF, k);
+        EXPECT_EQ(rerootV(toNewick(rooted_at_k), RerootMethod::LEAF, 0),
+                  rerootV(toNewick(v), RerootMethod::LEAF, 0));
+    }
+
+    // Half of the outgroup branch on each side of the root
+    std::vector<double> branch_lengths;
+    std::vector<std::array<int, 3>> M =
+        reroot(parseUnrootedNewick("((0:1,1:1):1,2:4);"), RerootMethod::LEAF, 2, branch_lengths);
+    EXPECT_EQ(fromAncestry(M), fromNewick("(2,(0,1));"));
+    EXPECT_DOUBLE_EQ(branch_lengths[2], 2.0);
+    EXPECT_DOUBLE_EQ(branch_lengths[0], 1.0);
+    // The branches of the former root are merged
+    EXPECT_DOUBLE_EQ(branch_lengths[M[0][1] == 2 ? M[0][2] : M[0][1]], 3.0);
+
+    EXPECT_THROW(rerootV("(0,1,2);", RerootMethod::LEAF, 3), std::out_of_range);
+}
+
+TEST(RerootTest, TestMidpoint) {
+    std::vector<double> branch_lengths;
+    std::vector<std::array<int, 3>> M = reroot(
+        parseUnrootedNewick("((0:1,1:1):1,(2:1,3:5):1);"), RerootMethod::MIDPOINT, -1,
+        branch_lengths);
+
+    EXPECT_EQ(fromAncestry(M), fromNewick("(3,((0,1),2));"));
+    EXPECT_DOUBLE_EQ(branch_lengths[3], 4.0);
+
+    // Without branch lengths: middle of the longest path in number of branches
+    EXPECT_EQ(rerootV("(0,(1,(2,(3,4))));", RerootMethod::MIDPOINT),
+              fromNewick("((0,1),(2,(3,4)));"));
+}
+
+TEST(RerootTest, TestLargeLadder) {
+    // Deep trees must not overflow the stack
+    const int k = 100000;
+    std::vector<int> v(k, 0);
+
+    EXPECT_EQ(rerootV(toNewick(v), RerootMethod::RESOLVE), v);
+    EXPECT_EQ(rerootV(toNewick(v), RerootMethod::MIDPOINT).size(), static_cast<std::size_t>(k));
+}
+
+TEST(RerootTest, TestNewick2V) {
+    std::string newick = "(0,1,(2,3));";
+    EXPECT_THROW(newick2v(newick), std::out_of_range);
+
+    newick = "(0,1,(2,3));";
+    Newick2VResult res = newick2v(newick, -1, RerootMethod::RESOLVE);
+    res.v.erase(res.v.begin());
+    EXPECT_EQ(res.num_leaves, 4);
+    EXPECT_EQ(res.v, fromNewick("((0,1),(2,3));"));
+
+    newick = "(a:1,b:1,(c:1,d:1):1);";
+    res = newick2vWithMapping(newick, -1, RerootMethod::LEAF, "c");
+    res.v.erase(res.v.begin());
+    EXPECT_EQ(res.mapping.at("2"), "c");
+    EXPECT_EQ(res.v, fromNewick("(2,(3,(0,1)));"));
+
+    EXPECT_THROW(newick2vWithMapping(newick, -1, RerootMethod::LEAF, "z"), std::invalid_argument);
+    EXPECT_THROW(newick2v(newick, -1, RerootMethod::LEAF, "c"), std::invalid_argument);
+    EXPECT_THROW(parseRerootMethod("sideways"), std::invalid_argument);
+    EXPECT_EQ(parseRerootMethod("midpoint"), RerootMethod::MIDPOINT);
+}
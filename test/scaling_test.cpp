@@ -0,0 +1,223 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <string>
+
+#include "../src/phylo2vec.hpp"
+
+/**
+ * Scaling suite: round trips of large trees under time and memory budgets
+ *
+ * For each tree shape, the conversions are timed at 1k, 10k, 100k and 1M leaves (median of
+ * repeated calls), and the time ratio of each function between consecutive large sizes is
+ * checked, so that a change that turns an O(n log n) function into an O(n^2) one fails the suite.
+ *
+ * PHYLO2VEC_SCALING_MAX_LEAVES (default: 1000000) limits the largest size, e.g. for sanitizer
+ * builds. Budgets are deliberately loose so that unoptimized builds pass.
+ */
+
+namespace {
+
+// Largest accepted time ratio between n and 10n leaves. n log n alone predicts about 12 from 100k
+// to 1M leaves, but cache misses on large trees raise measured ratios to about 15-30 (log-log
+// slopes of 1.2-1.5), more under load. O(n^2) gives 100.
+const double MAX_DECADE_RATIO = 50.0;
+// Ratios from smaller sizes are dominated by noise and cache effects
+const int MIN_RATIO_LEAVES = 100000;
+// Time budget per function call for 1M leaves, scaled linearly for other sizes
+const double SECONDS_PER_MILLION_LEAVES = 10.0;
+// Peak memory budget per function call
+const double BYTES_PER_LEAF = 256.0;
+const double BASE_BYTES = 64.0 * (1 << 20);
+// Number of timed calls per function and size (the median is kept)
+const int NUM_REPEATS = 5;
+const int NUM_REPEATS_LARGE = 3;
+
+int getMaxLeaves() {
+    const char *env = std::getenv("PHYLO2VEC_SCALING_MAX_LEAVES");
+    return env ? std::atoi(env) : 1000000;
+}
+
+/**
+ * @brief Reset the peak resident set size (Linux only)
+ *
+ * @return false if peak RSS cannot be measured
+ */
+bool resetPeakRSS() {
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    if (!clear_refs) {
+        return false;
+    }
+    clear_refs << "5";
+    clear_refs.close();
+    return !clear_refs.fail();
+}
+
+/**
+ * @brief Read a field of /proc/self/status in bytes (e.g., VmHWM: peak RSS, VmRSS: RSS)
+ */
+double getStatusBytes(const std::string &field) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, field.size() + 1, field + ":") == 0) {
+            return std::stod(line.substr(field.size() + 1)) * 1024;
+        }
+    }
+    return 0;
+}
+
+struct Measure {
+    double seconds;
+    // Peak RSS above the RSS before the call (-1 if unavailable)
+    double peak_bytes;
+};
+
+Measure measure(const std::function<void()> &f) {
+    const bool has_rss = resetPeakRSS();
+    const double rss_before = getStatusBytes("VmRSS");
+
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+
+    Measure m;
+    m.seconds = std::chrono::duration<double>(end - start).count();
+    m.peak_bytes = has_rss ? getStatusBytes("VmHWM") - rss_before : -1;
+    return m;
+}
+
+/**
+ * @brief Median of repeated measures: time and peak memory of f (the largest peak is kept)
+ */
+Measure measureMedian(const std::function<void()> &f, int num_repeats) {
+    std::vector<double> seconds;
+    double peak_bytes = -1;
+    for (int i = 0; i < num_repeats; ++i) {
+        Measure m = measure(f);
+        seconds.push_back(m.seconds);
+        peak_bytes = std::max(peak_bytes, m.peak_bytes);
+    }
+
+    std::nth_element(seconds.begin(), seconds.begin() + num_repeats / 2, seconds.end());
+    Measure m;
+    m.seconds = seconds[num_repeats / 2];
+    m.peak_bytes = peak_bytes;
+    return m;
+}
+
+// Caterpillar: each new leaf is the sister of leaf 0
+std::vector<int> ladderTree(int k) { return std::vector<int>(k, 0); }
+
+// Leaves are merged two by two, level by level
+std::vector<int> balancedTree(int k) {
+    std::vector<int> level(k + 1);
+    std::iota(level.begin(), level.end(), 0);
+
+    std::vector<std::array<int, 3>> M;
+    int next_label = k + 1;
+    while (level.size() > 1) {
+        std::vector<int> next_level;
+        for (std::size_t i = 0; i + 1 < level.size(); i += 2) {
+            M.push_back({{next_label, level[i], level[i + 1]}});
+            next_level.push_back(next_label++);
+        }
+        if (level.size() % 2 == 1) {
+            next_level.push_back(level.back());
+        }
+        level = next_level;
+    }
+
+    // Root first
+    std::reverse(M.begin(), M.end());
+    return fromAncestry(M);
+}
+
+}  // namespace
+
+class ScalingTest : public ::testing::TestWithParam<std::string> {};
+
+TEST_P(ScalingTest, TestRoundTrip) {
+    const std::string shape = GetParam();
+    const int max_leaves = getMaxLeaves();
+
+    // function -> (num_leaves, seconds)
+    std::map<std::string, std::vector<std::pair<int, double>>> timings;
+
+    for (int num_leaves = 1000; num_leaves <= max_leaves; num_leaves *= 10) {
+        const int k = num_leaves - 1;
+
+        std::vector<int> v;
+        if (shape == "ladder") {
+            v = ladderTree(k);
+        } else if (shape == "balanced") {
+            v = balancedTree(k);
+        } else {
+            v = sample(k);
+        }
+
+        std::vector<std::array<int, 3>> M;
+        std::string newick;
+        std::vector<int> v_from_ancestry, v_from_newick;
+
+        std::map<std::string, std::function<void()>> steps = {
+            {"getAncestry", [&]() { M = getAncestry(v); }},
+            {"buildNewick", [&]() { newick = buildNewick(M); }},
+            {"fromAncestry", [&]() { v_from_ancestry = fromAncestry(M); }},
+            {"toVector", [&]() { v_from_newick = toVector(newick, num_leaves); }},
+        };
+
+        for (const std::string name : {"getAncestry", "buildNewick", "fromAncestry", "toVector"}) {
+            const Measure m =
+                measureMedian(steps[name], num_leaves < 1000000 ? NUM_REPEATS : NUM_REPEATS_LARGE);
+
+            const double time_budget =
+                std::max(1.0, SECONDS_PER_MILLION_LEAVES * num_leaves / 1e6);
+            EXPECT_LT(m.seconds, time_budget)
+                << name << " on a " << shape << " tree with " << num_leaves << " leaves";
+
+            if (m.peak_bytes >= 0) {
+                EXPECT_LT(m.peak_bytes, BASE_BYTES + BYTES_PER_LEAF * num_leaves)
+                    << name << " on a " << shape << " tree with " << num_leaves << " leaves";
+            }
+
+            std::cout << "[ SCALING  ] " << shape << " " << name << " n=" << num_leaves << ": "
+                      << m.seconds << " s";
+            if (m.peak_bytes >= 0) {
+                std::cout << ", peak +" << m.peak_bytes / (1 << 20) << " MiB";
+            }
+            std::cout << std::endl;
+
+            timings[name].push_back(std::make_pair(num_leaves, m.seconds));
+        }
+
+        ASSERT_EQ(v_from_ancestry, v);
+        v_from_newick.erase(v_from_newick.begin());
+        ASSERT_EQ(v_from_newick, v);
+    }
+
+    for (const auto &timing : timings) {
+        const auto &points = timing.second;
+        for (std::size_t i = 1; i < points.size(); ++i) {
+            if (points[i - 1].first < MIN_RATIO_LEAVES) {
+                continue;
+            }
+            const double ratio = points[i].second / points[i - 1].second;
+            std::cout << "[ SCALING  ] " << shape << " " << timing.first << " ratio n="
+                      << points[i - 1].first << " -> " << points[i].first << ": " << ratio
+                      << std::endl;
+            EXPECT_LT(ratio, MAX_DECADE_RATIO)
+                << timing.first << " on " << shape << " trees from " << points[i - 1].first
+                << " to " << points[i].first << " leaves";
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Shapes, ScalingTest, ::testing::Values("ladder", "balanced", "random"));
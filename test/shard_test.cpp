@@ -0,0 +1,249 @@
+#include "../src/shard.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "../src/nexus.hpp"
+#include "../src/npy.hpp"
+#include "../src/phylo2vec.hpp"
+
+namespace {
+
+// Newick with leaves named t<i> (or translated to i + 1 tokens)
+std::string namedNewick(const std::vector<int> &v, bool translate) {
+    std::string newick = toNewick(v);
+    removeParentAnnotations(newick);
+
+    std::string named;
+    for (std::size_t i = 0; i < newick.size(); ++i) {
+        if (std::isdigit(static_cast<unsigned char>(newick[i]))) {
+            std::size_t end = i;
+            while (end < newick.size() && std::isdigit(static_cast<unsigned char>(newick[end]))) {
+                ++end;
+            }
+            const int leaf = std::stoi(newick.substr(i, end - i));
+            named += translate ? std::to_string(leaf + 1) : "t" + std::to_string(leaf);
+            i = end - 1;
+        } else {
+            named += newick[i];
+        }
+    }
+    return named;
+}
+
+void writeNexus(const std::string &path, int num_trees, int k, bool translate) {
+    std::ofstream file(path);
+    file << "#NEXUS\n[generated by shard_test]\nbegin trees;\n";
+    if (translate) {
+        file << "    translate\n";
+        for (int i = 0; i <= k; ++i) {
+            file << "        " << i + 1 << " t" << i << (i < k ? ",\n" : ";\n");
+        }
+    }
+    for (int i = 0; i < num_trees; ++i) {
+        file << "    tree STATE_" << i << " = [&U] " << namedNewick(sample(k), translate) << "\n";
+    }
+    file << "end;\n";
+}
+
+std::vector<std::string> readAll(std::istream &in) {
+    NexusReader reader(in);
+    std::vector<std::string> newicks;
+    NexusTree tree;
+    while (reader.next(tree)) {
+        newicks.push_back(tree.newick);
+    }
+    return newicks;
+}
+
+}  // namespace
+
+TEST(ShardTest, TestShardPath) {
+    EXPECT_EQ(getShardPath("trees.npy", 3), "trees.shard3.npy");
+    EXPECT_EQ(getShardPath("out/trees.txt.gz", 0), "out/trees.txt.shard0.gz");
+    EXPECT_EQ(getShardPath("out.d/trees", 1), "out.d/trees.shard1");
+    EXPECT_EQ(getShardPath(".hidden", 2), ".hidden.shard2");
+}
+
+TEST(ShardTest, TestPartition) {
+    const std::string path = "shard_test_trees.nex";
+
+    for (bool translate : {true, false}) {
+        writeNexus(path, 300, 20, translate);
+
+        std::ifstream file(path);
+        const std::vector<std::string> expected = readAll(file);
+
+        for (int num_shards : {1, 3, 7, 500}) {
+            ShardManifest manifest = partitionTrees(path, num_shards);
+
+            ASSERT_EQ(manifest.shards.size(), static_cast<std::size_t>(num_shards));
+            // Usable from any working directory
+            EXPECT_EQ(manifest.input.front(), '/');
+            EXPECT_EQ(manifest.input.substr(manifest.input.rfind('/') + 1), path);
+            EXPECT_EQ(manifest.taxa.size(), 21u);
+            if (translate) {
+                EXPECT_EQ(manifest.taxa[0], "t0");
+            }
+            EXPECT_EQ(manifest.shards.front().first, manifest.header_end);
+            EXPECT_EQ(manifest.shards.back().second, manifest.file_size);
+
+            // Manifest round trip
+            std::stringstream ss;
+            writeManifest(manifest, ss);
+            ShardManifest loaded = readManifest(ss);
+            EXPECT_EQ(loaded.input, manifest.input);
+            EXPECT_EQ(loaded.taxa, manifest.taxa);
+            EXPECT_EQ(loaded.shards, manifest.shards);
+
+            std::vector<std::string> newicks;
+            std::size_t max_shard_size = 0;
+            for (int i = 0; i < num_shards; ++i) {
+                if (i > 0) {
+                    EXPECT_EQ(manifest.shards[i].first, manifest.shards[i - 1].second);
+                }
+                max_shard_size = std::max<std::size_t>(
+                    max_shard_size, manifest.shards[i].second - manifest.shards[i].first);
+
+                ShardReader reader(loaded, i);
+                NexusTree tree;
+                while (reader.next(tree)) {
+                    newicks.push_back(tree.newick);
+                }
+                EXPECT_EQ(reader.taxa(), manifest.taxa);
+            }
+
+            // Same trees, same order, same leaf numbering
+            EXPECT_EQ(newicks, expected);
+
+            // Balanced (up to one line)
+            if (num_shards < 10) {
+                const std::size_t trees_size = manifest.file_size - manifest.header_end;
+                EXPECT_LT(max_shard_size, trees_size / num_shards + 200);
+            }
+        }
+    }
+
+    EXPECT_THROW(partitionTrees(path, 0), std::invalid_argument);
+
+    ShardManifest manifest = partitionTrees(path, 2);
+    EXPECT_THROW(ShardReader(manifest, 2), std::out_of_range);
+
+    // Modified input
+    writeNexus(path, 10, 20, true);
+    EXPECT_THROW(ShardReader(manifest, 0), std::runtime_error);
+
+    std::remove(path.c_str());
+}
+
+TEST(ShardTest, TestIntegerTaxonNames) {
+    const std::string path = "shard_test_integer_taxa.nex";
+
+    // Taxon names are integers, but not those of their TRANSLATE tokens
+    {
+        std::ofstream file(path);
+        file << "#NEXUS\nbegin trees;\n    translate 1 2, 2 1, 3 4, 4 3;\n";
+        file << "    tree t1 = ((1,2),(3,4));\n    tree t2 = (((2,3),4),1);\n";
+        file << "    tree t3 = ((4,1),(2,3));\n    tree t4 = (1,(2,(3,4)));\nend;\n";
+    }
+
+    std::ifstream file(path);
+    const std::vector<std::string> expected = readAll(file);
+    ASSERT_EQ(expected.front(), "((0,1),(2,3));");
+
+    ShardManifest manifest = partitionTrees(path, 2);
+    EXPECT_EQ(manifest.taxa, std::vector<std::string>({"2", "1", "4", "3"}));
+
+    std::vector<std::string> newicks;
+    for (int i = 0; i < 2; ++i) {
+        ShardReader reader(manifest, i);
+        NexusTree tree;
+        while (reader.next(tree)) {
+            newicks.push_back(tree.newick);
+        }
+        EXPECT_EQ(reader.taxa(), manifest.taxa);
+    }
+    EXPECT_EQ(newicks, expected);
+
+    std::remove(path.c_str());
+}
+
+TEST(ShardTest, TestInvalidManifest) {
+    std::istringstream iss("P2VS 1\ninput trees.nex\nsize 10\n");
+    EXPECT_THROW(readManifest(iss), std::runtime_error);
+
+    std::istringstream bad_magic("P2VC 1\n");
+    EXPECT_THROW(readManifest(bad_magic), std::runtime_error);
+}
+
+TEST(ShardTest, TestMerge) {
+    ShardManifest manifest;
+    manifest.shards.resize(3);
+
+    std::vector<std::vector<int>> vs;
+    for (int i = 0; i < 10; ++i) {
+        vs.push_back(sample(15));
+    }
+    const std::size_t bounds[] = {0, 4, 4, 10};
+
+    // NumPy outputs (shard 1 is empty)
+    for (int i = 0; i < 3; ++i) {
+        NpyWriter writer(getShardPath("shard_test_merged.npy", i), {15});
+        for (std::size_t j = bounds[i]; j < bounds[i + 1]; ++j) {
+            writer.write(vs[j]);
+        }
+        writer.close();
+    }
+    EXPECT_EQ(mergeShardOutputs(manifest, "shard_test_merged.npy"), vs.size());
+    {
+        MappedNpy merged("shard_test_merged.npy");
+        ASSERT_EQ(merged.num_rows(), vs.size());
+        for (std::size_t j = 0; j < vs.size(); ++j) {
+            EXPECT_EQ(merged.getRow(j), vs[j]);
+        }
+    }
+
+    // Text outputs
+    for (int i = 0; i < 3; ++i) {
+        std::ofstream file(getShardPath("shard_test_merged.txt", i));
+        for (std::size_t j = bounds[i]; j < bounds[i + 1]; ++j) {
+            for (int x : vs[j]) {
+                file << x << " ";
+            }
+            file << "\n";
+        }
+    }
+    EXPECT_EQ(mergeShardOutputs(manifest, "shard_test_merged.txt"), vs.size());
+    {
+        std::ifstream merged("shard_test_merged.txt");
+        std::string line;
+        std::size_t j = 0;
+        while (std::getline(merged, line)) {
+            std::istringstream iss(line);
+            std::vector<int> v;
+            int x;
+            while (iss >> x) {
+                v.push_back(x);
+            }
+            ASSERT_LT(j, vs.size());
+            EXPECT_EQ(v, vs[j++]);
+        }
+        EXPECT_EQ(j, vs.size());
+    }
+
+    // Missing shard output
+    std::remove(getShardPath("shard_test_merged.txt", 2).c_str());
+    EXPECT_THROW(mergeShardOutputs(manifest, "shard_test_merged.txt"), std::runtime_error);
+
+    for (const std::string path : {"shard_test_merged.npy", "shard_test_merged.txt"}) {
+        for (int i = 0; i < 3; ++i) {
+            std::remove(getShardPath(path, i).c_str());
+        }
+        std::remove(path.c_str());
+    }
+}
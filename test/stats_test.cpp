@@ -0,0 +1,63 @@
+#include "../src/stats.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <numeric>
+
+#include "../src/phylo2vec.hpp"
+
+TEST(TreeStatsTest, TestLadderTree) {
+    // (((2,1)4,0)5,3)6;
+    TreeStats stats = getTreeStats(std::vector<int>({0, 1, 4}));
+
+    EXPECT_EQ(stats.depths, std::vector<int>({2, 3, 3, 1}));
+    EXPECT_EQ(stats.sackin, 9);
+    EXPECT_EQ(stats.colless, 3);
+    EXPECT_EQ(stats.cherries, 1);
+    EXPECT_EQ(stats.height, 3);
+}
+
+TEST(TreeStatsTest, TestBalancedTree) {
+    // ((3,1)4,(2,0)5)6;
+    TreeStats stats = getTreeStats(std::vector<int>({0, 0, 1}));
+
+    EXPECT_EQ(stats.depths, std::vector<int>({2, 2, 2, 2}));
+    EXPECT_EQ(stats.sackin, 8);
+    EXPECT_EQ(stats.colless, 0);
+    EXPECT_EQ(stats.cherries, 2);
+    EXPECT_EQ(stats.height, 2);
+}
+
+TEST(TreeStatsTest, TestInvalidVectors) {
+    EXPECT_THROW(getTreeStats(std::vector<int>({0, 5, 1})), std::out_of_range);
+    EXPECT_THROW(getTreeStats(std::vector<std::vector<int>>({{0, 1}, {3}})), std::out_of_range);
+}
+
+TEST(TreeStatsTest, TestBatch) {
+    std::vector<std::vector<int>> vs;
+    for (int k = 1; k < 60; ++k) {
+        vs.push_back(sample(k));
+    }
+
+    TreeStatsBatch batch = getTreeStats(vs);
+
+    ASSERT_EQ(batch.depth_offsets.size(), vs.size() + 1);
+
+    for (std::size_t i = 0; i < vs.size(); ++i) {
+        TreeStats stats = getTreeStats(vs[i]);
+
+        std::vector<int> depths(batch.depths.begin() + batch.depth_offsets[i],
+                                batch.depths.begin() + batch.depth_offsets[i + 1]);
+
+        EXPECT_EQ(depths, stats.depths);
+        EXPECT_EQ(batch.sackin[i], stats.sackin);
+        EXPECT_EQ(batch.colless[i], stats.colless);
+        EXPECT_EQ(batch.cherries[i], stats.cherries);
+        EXPECT_EQ(batch.height[i], stats.height);
+
+        EXPECT_EQ(stats.sackin, std::accumulate(depths.begin(), depths.end(), 0LL));
+        EXPECT_EQ(stats.height, *std::max_element(depths.begin(), depths.end()));
+        EXPECT_GE(stats.cherries, 1);
+    }
+}